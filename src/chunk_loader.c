@@ -0,0 +1,271 @@
+#include "scene.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include "util/perf.h"
+#include "util/profiler.h"
+
+extern void generate_chunk(chunk_t *chunk, int chunk_x, int chunk_z); // in scene.c
+
+#define MAX_CHUNK_WORKERS 8
+
+typedef enum {
+  JOB_FREE,
+  JOB_QUEUED,     // waiting for a worker
+  JOB_RUNNING,    // a worker is generating it
+  JOB_CANCELLED,  // running, but nobody wants the result anymore
+  JOB_DONE        // generated, waiting to be published
+} chunk_job_state_t;
+
+typedef struct {
+  chunk_t chunk;          // x/z are set at request time so query_funcs can inspect queued jobs
+  float priority;         // lower runs first (distance to the camera)
+  uint64_t gen_time;      // performance counter ticks spent in generate_chunk
+  chunk_job_state_t state;
+} chunk_job_t;
+
+typedef struct {
+  chunk_job_t *jobs;
+  usize num_jobs;
+
+  SDL_Thread *workers[MAX_CHUNK_WORKERS];
+  usize num_workers;
+
+  SDL_Mutex *lock;
+  SDL_Condition *work_available;
+  SDL_Condition *work_done;   // a worker finished a job
+  bool shutting_down;
+} chunk_loader_t;
+
+static chunk_loader_t loader = {0};
+
+static chunk_job_t *find_job(int x, int z) {
+  for (usize i = 0; i < loader.num_jobs; ++i) {
+    chunk_job_t *job = &loader.jobs[i];
+    if (job->state != JOB_FREE && job->state != JOB_CANCELLED && job->chunk.x == x && job->chunk.z == z)
+      return job;
+  }
+
+  return NULL;
+}
+
+// nearest queued job, caller holds the lock
+static chunk_job_t *next_job(void) {
+  chunk_job_t *best = NULL;
+
+  for (usize i = 0; i < loader.num_jobs; ++i) {
+    chunk_job_t *job = &loader.jobs[i];
+    if (job->state == JOB_QUEUED && (!best || job->priority < best->priority))
+      best = job;
+  }
+
+  return best;
+}
+
+static int chunk_worker(void *data) {
+  (void)data;
+
+  SDL_LockMutex(loader.lock);
+  while (true) {
+    chunk_job_t *job = NULL;
+    while (!loader.shutting_down && (job = next_job()) == NULL) {
+      SDL_WaitCondition(loader.work_available, loader.lock);
+    }
+
+    if (loader.shutting_down) break;
+
+    job->state = JOB_RUNNING;
+    int x = job->chunk.x, z = job->chunk.z;
+    SDL_UnlockMutex(loader.lock);
+
+    // generate outside the lock into a local so the slot is never written concurrently
+    chunk_t chunk = {0};
+    uint64_t start = SDL_GetPerformanceCounter();
+    generate_chunk(&chunk, x, z);
+    uint64_t gen_time = SDL_GetPerformanceCounter() - start;
+
+    SDL_LockMutex(loader.lock);
+    if (job->state == JOB_CANCELLED) {
+      free_chunk(&chunk);
+      job->state = JOB_FREE;
+    } else {
+      job->chunk = chunk;
+      job->gen_time = gen_time;
+      job->state = JOB_DONE;
+    }
+
+    SDL_BroadcastCondition(loader.work_done);
+  }
+  SDL_UnlockMutex(loader.lock);
+
+  return 0;
+}
+
+void init_chunk_loader(usize max_pending, usize num_workers) {
+  if (loader.jobs) return;
+
+  if (num_workers == 0) {
+    int cores = SDL_GetNumLogicalCPUCores();
+    num_workers = cores > 1 ? (usize)(cores - 1) : 1;
+  }
+  if (num_workers > MAX_CHUNK_WORKERS) num_workers = MAX_CHUNK_WORKERS;
+
+  // cancelled jobs hold their slot until the worker finishes, leave room for one per worker
+  usize max_jobs = max_pending + num_workers;
+  loader.jobs = calloc(max_jobs, sizeof(chunk_job_t));
+  loader.num_jobs = loader.jobs ? max_jobs : 0;
+  loader.lock = SDL_CreateMutex();
+  loader.work_available = SDL_CreateCondition();
+  loader.work_done = SDL_CreateCondition();
+  loader.shutting_down = false;
+
+  for (usize i = 0; i < num_workers; ++i) {
+    loader.workers[i] = SDL_CreateThread(chunk_worker, "chunk_worker", NULL);
+    if (!loader.workers[i]) {
+      printf("Failed to start chunk worker: %s\n", SDL_GetError());
+      break;
+    }
+
+    loader.num_workers++;
+  }
+}
+
+void free_chunk_loader(void) {
+  if (!loader.jobs) return;
+
+  SDL_LockMutex(loader.lock);
+  loader.shutting_down = true;
+  SDL_BroadcastCondition(loader.work_available);
+  SDL_UnlockMutex(loader.lock);
+
+  for (usize i = 0; i < loader.num_workers; ++i) {
+    SDL_WaitThread(loader.workers[i], NULL);
+  }
+
+  for (usize i = 0; i < loader.num_jobs; ++i) {
+    if (loader.jobs[i].state == JOB_DONE) free_chunk(&loader.jobs[i].chunk);
+  }
+
+  SDL_DestroyCondition(loader.work_done);
+  SDL_DestroyCondition(loader.work_available);
+  SDL_DestroyMutex(loader.lock);
+  free(loader.jobs);
+
+  loader = (chunk_loader_t){0};
+}
+
+// Queue a chunk for generation, or update its priority if it is already queued
+// Returns false when every job slot is in use, the caller should retry next tick
+bool chunk_loader_request(int x, int z, float priority) {
+  if (!loader.jobs) return false;
+
+  bool queued = true;
+
+  SDL_LockMutex(loader.lock);
+  chunk_job_t *job = find_job(x, z);
+
+  if (job) {
+    job->priority = priority;
+  } else {
+    for (usize i = 0; i < loader.num_jobs && !job; ++i) {
+      if (loader.jobs[i].state == JOB_FREE) job = &loader.jobs[i];
+    }
+
+    if (job) {
+      job->chunk = (chunk_t){0};
+      job->chunk.x = x;
+      job->chunk.z = z;
+      job->priority = priority;
+      job->state = JOB_QUEUED;
+      SDL_SignalCondition(loader.work_available);
+    } else {
+      queued = false;
+    }
+  }
+  SDL_UnlockMutex(loader.lock);
+
+  return queued;
+}
+
+bool chunk_loader_is_pending(int x, int z) {
+  if (!loader.jobs) return false;
+
+  SDL_LockMutex(loader.lock);
+  bool pending = find_job(x, z) != NULL;
+  SDL_UnlockMutex(loader.lock);
+
+  return pending;
+}
+
+// Drop every job func returns true for, running jobs finish but their result is discarded
+void chunk_loader_cancel_if(query_func func, void *param, usize num_params) {
+  if (!loader.jobs) return;
+
+  SDL_LockMutex(loader.lock);
+  for (usize i = 0; i < loader.num_jobs; ++i) {
+    chunk_job_t *job = &loader.jobs[i];
+    if (job->state == JOB_FREE || job->state == JOB_CANCELLED) continue;
+    if (!func(&job->chunk, param, num_params)) continue;
+
+    switch (job->state) {
+      case JOB_QUEUED:  job->state = JOB_FREE; break;
+      case JOB_RUNNING: job->state = JOB_CANCELLED; break;
+      case JOB_DONE:    free_chunk(&job->chunk); job->state = JOB_FREE; break;
+      default: break;
+    }
+  }
+  SDL_UnlockMutex(loader.lock);
+}
+
+// true while a job is waiting for or held by a worker, caller holds the lock
+static bool jobs_in_flight(void) {
+  for (usize i = 0; i < loader.num_jobs; ++i) {
+    chunk_job_state_t state = loader.jobs[i].state;
+    if (state == JOB_QUEUED || state == JOB_RUNNING || state == JOB_CANCELLED) return true;
+  }
+
+  return false;
+}
+
+// Block until every requested chunk is generated, what a publish then finds no longer depends on
+// how fast the workers were
+void chunk_loader_wait_idle(void) {
+  if (!loader.jobs || loader.num_workers == 0) return;
+
+  SDL_LockMutex(loader.lock);
+  while (jobs_in_flight()) {
+    SDL_WaitCondition(loader.work_done, loader.lock);
+  }
+  SDL_UnlockMutex(loader.lock);
+}
+
+// Move finished chunks into the map, called once per tick from the tick thread
+usize chunk_loader_publish(chunk_map_t *map, scene_stats_t *stats) {
+  if (!loader.jobs || !map) return 0;
+
+  usize published = 0;
+
+  SDL_LockMutex(loader.lock);
+  for (usize i = 0; i < loader.num_jobs; ++i) {
+    chunk_job_t *job = &loader.jobs[i];
+    if (job->state != JOB_DONE) continue;
+
+    insert_chunk(map, &job->chunk);
+    job->state = JOB_FREE;
+    published++;
+
+    if (stats) {
+      stats->chunks_generated++;
+      stats->chunk_gen_time += job->gen_time;
+    }
+
+    profiler_add(PROFILE_CHUNK_GEN, perf_elapsed_ms(0, job->gen_time));
+    profiler_note_chunk(job->chunk.x, job->chunk.z);
+  }
+  SDL_UnlockMutex(loader.lock);
+
+  return published;
+}
@@ -0,0 +1,191 @@
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <shader-works/maths.h>
+#include <shader-works/primitives.h>
+#include <shader-works/renderer.h>
+#include <shader-works/shaders.h>
+
+#include "scene.h"
+#include "util/projection.h"
+
+// Deferred shading through a visibility buffer. The visibility pass draws the scene with shaders
+// that only return a 32 bit id of what covers the pixel, so render_model's depth test leaves the
+// id of the nearest surface in the framebuffer. resolve_visibility_buffer then rebuilds the world
+// position from the depth buffer and runs the real material shader once per covered pixel.
+//
+// This relies on render_model storing what the fragment shader returns in the framebuffer as is,
+// with no blending, format conversion or value treated as transparent, leaving FLT_MAX in the
+// depth buffer of every pixel it did not draw, and passing the lit surface's normal in the fragment
+// context. tests/test_deferred.c checks all of it by resolving a frame drawn through render_model
+// against the same frame shaded forward.
+//
+// id layout, material in the top 4 bits:
+//   ground, tree, snow   octahedral normal, 14 bits per axis
+//   impostor             sprite texel as RGB565 above a 6 bit per axis octahedral normal
+
+extern fragment_shader_t tree_frag;            // in shaders.c
+extern fragment_shader_t white_frag;           // in shaders.c
+
+typedef enum {
+  MATERIAL_NONE,
+  MATERIAL_GROUND,
+  MATERIAL_TREE,
+  MATERIAL_SNOW,
+  MATERIAL_IMPOSTOR
+} material_t;
+
+#define MATERIAL_SHIFT 28
+#define NORMAL_BITS 14
+#define IMPOSTOR_NORMAL_BITS 6
+
+static inline float sign_not_zero(float v) {
+  return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+static inline u32 quantize(float v, int bits) {
+  float max = (float)((1u << bits) - 1);
+  float q = (v * 0.5f + 0.5f) * max + 0.5f;
+  return (u32)(q < 0.0f ? 0.0f : (q > max ? max : q));
+}
+
+static inline float dequantize(u32 q, int bits) {
+  return (float)q / (float)((1u << bits) - 1) * 2.0f - 1.0f;
+}
+
+static u32 encode_normal(float3 n, int bits) {
+  float sum = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+  if (sum <= 0.0f) return 0;
+
+  float u = n.x / sum, v = n.z / sum;
+  if (n.y < 0.0f) {
+    float fold_u = (1.0f - fabsf(v)) * sign_not_zero(u);
+    v = (1.0f - fabsf(u)) * sign_not_zero(v);
+    u = fold_u;
+  }
+
+  return (quantize(u, bits) << bits) | quantize(v, bits);
+}
+
+static float3 decode_normal(u32 bits_uv, int bits) {
+  float u = dequantize((bits_uv >> bits) & ((1u << bits) - 1), bits);
+  float v = dequantize(bits_uv & ((1u << bits) - 1), bits);
+  float y = 1.0f - fabsf(u) - fabsf(v);
+
+  if (y < 0.0f) {
+    float unfold_u = (1.0f - fabsf(v)) * sign_not_zero(u);
+    v = (1.0f - fabsf(u)) * sign_not_zero(v);
+    u = unfold_u;
+  }
+
+  return float3_normalize(make_float3(u, y, v));
+}
+
+static inline u32 surface_id(material_t material, const fragment_context_t *ctx) {
+  return ((u32)material << MATERIAL_SHIFT) | encode_normal(ctx->normal, NORMAL_BITS);
+}
+
+static u32 ground_visibility_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)args; (void)argc;
+  return surface_id(MATERIAL_GROUND, ctx);
+}
+
+static u32 tree_visibility_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)args; (void)argc;
+  return surface_id(MATERIAL_TREE, ctx);
+}
+
+fragment_shader_t ground_visibility_frag = { .func = ground_visibility_func, .argv = NULL, .argc = 0, .valid = true };
+fragment_shader_t tree_visibility_frag = { .func = tree_visibility_func, .argv = NULL, .argc = 0, .valid = true };
+
+// Snow is splatted by render_point_sprites rather than rasterized, flakes face the camera
+u32 snow_visibility_id(void) {
+  return ((u32)MATERIAL_SNOW << MATERIAL_SHIFT) | encode_normal(make_float3(0, 1, 0), NORMAL_BITS);
+}
+
+u32 impostor_visibility_id(u32 texel, const fragment_context_t *ctx) {
+  u8 r, g, b;
+  u32_to_rgb(texel, &r, &g, &b);
+  u32 rgb565 = ((u32)(r >> 3) << 11) | ((u32)(g >> 2) << 5) | (u32)(b >> 3);
+
+  return ((u32)MATERIAL_IMPOSTOR << MATERIAL_SHIFT) | (rgb565 << (2 * IMPOSTOR_NORMAL_BITS)) | encode_normal(ctx->normal, IMPOSTOR_NORMAL_BITS);
+}
+
+// The context render_model hands a fragment shader, rebuilt for one pixel of the visibility buffer.
+// Nothing is carried over from the visibility pass, the fields the shaders read are filled in: the
+// material shaders read world_pos, default_lighting_frag_shader the normal and the lights
+static inline fragment_context_t resolve_context(float3 world_pos, float3 normal, light_t *lights, usize num_lights) {
+  fragment_context_t ctx = { 0 };
+  ctx.world_pos = world_pos;
+  ctx.normal = normal;
+  ctx.light = lights;
+  ctx.num_lights = num_lights;
+  return ctx;
+}
+
+usize resolve_visibility_buffer(renderer_t *state, scene_t *scene, light_t *lights, usize num_lights) {
+  if (!state || !scene) return 0;
+
+  screen_projection_t projection;
+  init_screen_projection(&projection, state, &scene->camera_pos);
+
+  fragment_shader_t ground_frag = ground_shadow_shader(scene);
+  usize shaded = 0;
+  for (uint y = 0; y < state->height; ++y) {
+    for (uint x = 0; x < state->width; ++x) {
+      usize i = (usize)y * state->width + x;
+
+      float depth = state->depth_buffer[i];
+      if (depth == FLT_MAX) continue;
+
+      u32 id = state->framebuffer[i];
+      material_t material = (material_t)(id >> MATERIAL_SHIFT);
+      if (material == MATERIAL_NONE || material > MATERIAL_IMPOSTOR) continue;   // not written by the visibility pass
+
+      float3 world_pos = unproject_from_screen(&projection, (float)x + 0.5f, (float)y + 0.5f, depth);
+      float3 normal = decode_normal(id, material == MATERIAL_IMPOSTOR ? IMPOSTOR_NORMAL_BITS : NORMAL_BITS);
+      fragment_context_t ctx = resolve_context(world_pos, normal, lights, num_lights);
+
+      switch (material) {
+        case MATERIAL_GROUND:
+          state->framebuffer[i] = ground_frag.func(0, &ctx, ground_frag.argv, ground_frag.argc);
+          break;
+        case MATERIAL_TREE:
+          state->framebuffer[i] = tree_frag.func(0, &ctx, tree_frag.argv, tree_frag.argc);
+          break;
+        case MATERIAL_SNOW:
+          state->framebuffer[i] = white_frag.func(0, &ctx, white_frag.argv, white_frag.argc);
+          break;
+        case MATERIAL_IMPOSTOR: {
+          u32 rgb565 = (id >> (2 * IMPOSTOR_NORMAL_BITS)) & 0xffff;
+          u8 r = (u8)(((rgb565 >> 11) & 0x1f) * 255 / 31);
+          u8 g = (u8)(((rgb565 >> 5) & 0x3f) * 255 / 63);
+          u8 b = (u8)((rgb565 & 0x1f) * 255 / 31);
+
+          state->framebuffer[i] = shade_impostor_texel(rgb_to_u32(r, g, b), &ctx);
+          break;
+        }
+        default:
+          continue;
+      }
+
+      shaded++;
+    }
+  }
+
+  return shaded;
+}
+
+usize count_covered_pixels(const renderer_t *state) {
+  if (!state) return 0;
+
+  usize covered = 0;
+  usize num_pixels = (usize)state->width * state->height;
+  for (usize i = 0; i < num_pixels; ++i) {
+    covered += state->depth_buffer[i] != FLT_MAX;
+  }
+
+  return covered;
+}
@@ -0,0 +1,67 @@
+#include "scene.h"
+
+#include <stdlib.h>
+
+// Draws recorded by render_loaded_chunks are replayed in list order on the calling thread.
+// render_model has no viewport or scissor, so the list can't be split between threads that each
+// own part of the screen without every thread rasterizing whole draws. A renderer_t cut down to a
+// band of rows, its buffers pointing at the band, is no way around it: render_model centers the
+// projection on the renderer's own height, so each band would hold its own view instead of its
+// slice of the frame. Only one thread ever calls into shader-works, any parallelism inside
+// render_model comes from SHADER_WORKS_USE_THREADS.
+
+static usize draw_item(renderer_t *state, transform_t *camera, const draw_item_t *item, light_t *lights, usize num_lights) {
+  if (item->impostor) {
+    return render_tree_impostor(state, camera, item->impostor, item->tree, lights, num_lights, item->pass);
+  }
+
+  // ground models are shared by chunks and trees by the library, each draw places and shades a
+  // copy of the model. Trees are turned by the transform's yaw and drawn at their baked scale
+  model_t model;
+  if (item->tree) {
+    const tree_archetype_t *archetype = tree_archetype(item->tree->archetype);
+    if (!archetype) return 0;
+
+    model = archetype->models[tree_instance_scale_step(item->tree)];
+    model.transform.yaw = tree_instance_yaw(item->tree);
+  } else {
+    model = *item->model;
+  }
+
+  model.transform.position = item->position;
+  model.frag_shader = item->frag_shader;
+  return render_model(state, camera, &model, lights, num_lights);
+}
+
+bool push_draw_item(draw_list_t *list, const draw_item_t *item) {
+  if (list->count == list->capacity) {
+    usize capacity = list->capacity ? list->capacity * 2 : 256;
+    draw_item_t *items = realloc(list->items, capacity * sizeof(draw_item_t));
+    if (!items) return false;
+
+    list->items = items;
+    list->capacity = capacity;
+  }
+
+  list->items[list->count++] = *item;
+  return true;
+}
+
+void free_draw_list(draw_list_t *list) {
+  free(list->items);
+  *list = (draw_list_t){0};
+}
+
+usize render_draw_list(renderer_t *state, transform_t *camera, draw_list_t *list, light_t *lights, usize num_lights) {
+  usize triangles = 0;
+  for (usize i = 0; i < list->count; ++i) {
+    triangles += draw_item(state, camera, &list->items[i], lights, num_lights);
+  }
+
+  return triangles;
+}
+
+usize render_draw_item(renderer_t *state, transform_t *camera, draw_list_t *list, usize index, light_t *lights, usize num_lights) {
+  if (index >= list->count) return 0;
+  return draw_item(state, camera, &list->items[index], lights, num_lights);
+}
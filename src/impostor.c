@@ -0,0 +1,285 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <shader-works/maths.h>
+#include <shader-works/primitives.h>
+#include <shader-works/renderer.h>
+#include <shader-works/shaders.h>
+
+#include "scene.h"
+
+// Distant trees are drawn as camera facing sprites. Each tree archetype is rendered orthographically from
+// IMPOSTOR_VIEWS horizontal directions into small sprites, and each sprite gets a silhouette mesh
+// of one quad per opaque row so no alpha testing is needed. The quads go through billboard_vs and
+// impostor_frag_func looks the color up from the sprite of the view closest to the camera. An
+// instance's turn picks which view that is, its scale grows the quads and the texel lookup alike.
+
+extern vertex_shader_t billboard_vs; // in shaders.c
+
+// Sprite being drawn, the impostor shaders read it during render_model
+typedef struct {
+  const tree_impostor_t *impostor;
+  const u32 *sprite;
+  float3 base, right, up;
+  float scale;
+} impostor_draw_t;
+
+u32 shade_impostor_texel(u32 texel, fragment_context_t *ctx) {
+  count_shaded_fragment();
+  return default_lighting_frag_shader.func(texel, ctx, NULL, 0);
+}
+
+// Sprite texel under the fragment
+static u32 impostor_texel(const impostor_draw_t *draw, const fragment_context_t *ctx) {
+  float3 offset = float3_scale(float3_sub(ctx->world_pos, draw->base), 1.0f / draw->scale);
+  float u = float3_dot(offset, draw->right) / (2.0f * draw->impostor->half_width) + 0.5f;
+  float v = (float3_dot(offset, draw->up) - draw->impostor->bottom) / draw->impostor->height;
+
+  int tx = (int)(u * IMPOSTOR_WIDTH);
+  int ty = (int)(v * IMPOSTOR_HEIGHT);
+  tx = tx < 0 ? 0 : (tx >= IMPOSTOR_WIDTH ? IMPOSTOR_WIDTH - 1 : tx);
+  ty = ty < 0 ? 0 : (ty >= IMPOSTOR_HEIGHT ? IMPOSTOR_HEIGHT - 1 : ty);
+
+  return draw->sprite[ty * IMPOSTOR_WIDTH + tx];
+}
+
+static u32 impostor_frag_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)argc;
+  return shade_impostor_texel(impostor_texel((const impostor_draw_t*)args, ctx), ctx);
+}
+
+// The texel is looked up here, lighting waits for resolve_visibility_buffer
+static u32 impostor_visibility_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)argc;
+  return impostor_visibility_id(impostor_texel((const impostor_draw_t*)args, ctx), ctx);
+}
+
+// Horizontal sprite axis of view k, the depth axis is its perpendicular (sin, 0, cos)
+static inline float3 view_axis(usize view) {
+  float angle = (2.0f * PI * (float)view) / IMPOSTOR_VIEWS;
+  return make_float3(cosf(angle), 0.0f, -sinf(angle));
+}
+
+static inline float edge(float ax, float ay, float bx, float by, float px, float py) {
+  return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// Orthographic z-buffered rasterization of the tree into one sprite, empty texels stay 0. Coverage is
+// conservative (any overlap with the texel counts), branches are thinner than a texel at this size
+static void bake_view(const model_t *tree, const tree_impostor_t *impostor, float3 base, usize view, u32 *sprite) {
+  float depth[IMPOSTOR_WIDTH * IMPOSTOR_HEIGHT];
+  for (usize i = 0; i < IMPOSTOR_WIDTH * IMPOSTOR_HEIGHT; ++i) depth[i] = INFINITY;
+
+  float3 axis = view_axis(view);
+  float3 toward = make_float3(-axis.z, 0.0f, axis.x);
+  float3 light = float3_normalize(make_float3(0.3f, 1.0f, 0.3f));
+
+  for (usize f = 0; f < tree->num_faces; ++f) {
+    float px[3], py[3], pz[3];
+
+    for (usize v = 0; v < 3; ++v) {
+      float3 p = float3_sub(tree->vertex_data[f * 3 + v].position, base);
+      px[v] = (float3_dot(p, axis) / (2.0f * impostor->half_width) + 0.5f) * IMPOSTOR_WIDTH;
+      py[v] = (p.y - impostor->bottom) / impostor->height * IMPOSTOR_HEIGHT;
+      pz[v] = float3_dot(p, toward);
+    }
+
+    float area = edge(px[0], py[0], px[1], py[1], px[2], py[2]);
+    if (fabsf(area) < 1e-6f) continue;
+
+    // same bark tone as tree_frag with a fixed top light so the crown keeps its shape at a distance
+    float shade = 0.75f + 0.25f * fmaxf(0.0f, float3_dot(tree->face_normals[f], light));
+    u32 color = rgb_to_u32((u8)(110.0f * 0.8f * shade), (u8)(90.0f * 0.8f * shade), (u8)(40.0f * 0.8f * shade));
+
+    int min_x = (int)fmaxf(0.0f, floorf(fminf(px[0], fminf(px[1], px[2]))));
+    int max_x = (int)fminf(IMPOSTOR_WIDTH - 1, ceilf(fmaxf(px[0], fmaxf(px[1], px[2]))));
+    int min_y = (int)fmaxf(0.0f, floorf(fminf(py[0], fminf(py[1], py[2]))));
+    int max_y = (int)fminf(IMPOSTOR_HEIGHT - 1, ceilf(fmaxf(py[0], fmaxf(py[1], py[2]))));
+
+    // moving the sample anywhere within the texel changes an edge function by at most this much
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    float slack0 = 0.5f * (fabsf(px[2] - px[1]) + fabsf(py[2] - py[1]));
+    float slack1 = 0.5f * (fabsf(px[0] - px[2]) + fabsf(py[0] - py[2]));
+    float slack2 = 0.5f * (fabsf(px[1] - px[0]) + fabsf(py[1] - py[0]));
+
+    for (int y = min_y; y <= max_y; ++y) {
+      for (int x = min_x; x <= max_x; ++x) {
+        float cx = (float)x + 0.5f, cy = (float)y + 0.5f;
+        float e0 = edge(px[1], py[1], px[2], py[2], cx, cy) * sign;
+        float e1 = edge(px[2], py[2], px[0], py[0], cx, cy) * sign;
+        float e2 = edge(px[0], py[0], px[1], py[1], cx, cy) * sign;
+        if (e0 < -slack0 || e1 < -slack1 || e2 < -slack2) continue;
+
+        float w0 = e0 * sign / area;
+        float w1 = e1 * sign / area;
+        float z = w0 * pz[0] + w1 * pz[1] + (1.0f - w0 - w1) * pz[2];
+        if (z >= depth[y * IMPOSTOR_WIDTH + x]) continue;
+
+        depth[y * IMPOSTOR_WIDTH + x] = z;
+        sprite[y * IMPOSTOR_WIDTH + x] = color;
+      }
+    }
+  }
+}
+
+// One quad per sprite row spanning its opaque texels, gaps inside a row take the nearest color
+static int build_silhouette(model_t *mesh, const model_t *quad_template, const tree_impostor_t *impostor, u32 *sprite) {
+  int spans[IMPOSTOR_HEIGHT][2];
+  usize num_rows = 0;
+
+  for (int y = 0; y < IMPOSTOR_HEIGHT; ++y) {
+    u32 *row = sprite + y * IMPOSTOR_WIDTH;
+    spans[y][0] = -1;
+
+    for (int x = 0; x < IMPOSTOR_WIDTH; ++x) {
+      if (row[x] == 0) continue;
+      if (spans[y][0] < 0) spans[y][0] = x;
+      spans[y][1] = x;
+    }
+    if (spans[y][0] < 0) continue;
+
+    for (int x = spans[y][0] + 1; x <= spans[y][1]; ++x) {
+      if (row[x] == 0) row[x] = row[x - 1];
+    }
+    num_rows++;
+  }
+
+  *mesh = (model_t){0};
+  if (num_rows == 0) return 0;
+
+  mesh->vertex_data = malloc(num_rows * quad_template->num_vertices * sizeof(vertex_data_t));
+  mesh->face_normals = malloc(num_rows * quad_template->num_faces * sizeof(float3));
+  if (!mesh->vertex_data || !mesh->face_normals) {
+    delete_model(mesh);
+    return -1;
+  }
+
+  for (int y = 0; y < IMPOSTOR_HEIGHT; ++y) {
+    if (spans[y][0] < 0) continue;
+
+    float x0 = ((float)spans[y][0] / IMPOSTOR_WIDTH - 0.5f) * 2.0f * impostor->half_width;
+    float x1 = ((float)(spans[y][1] + 1) / IMPOSTOR_WIDTH - 0.5f) * 2.0f * impostor->half_width;
+    float y0 = impostor->bottom + (float)y / IMPOSTOR_HEIGHT * impostor->height;
+    float y1 = impostor->bottom + (float)(y + 1) / IMPOSTOR_HEIGHT * impostor->height;
+
+    // corners follow generate_quad's vertex order so the winding matches generate_quad's billboards
+    for (usize v = 0; v < quad_template->num_vertices; ++v) {
+      vertex_data_t vertex = quad_template->vertex_data[v];
+      vertex.position = make_float3(vertex.position.x > 0.0f ? x1 : x0, vertex.position.y > 0.0f ? y1 : y0, 0.0f);
+      mesh->vertex_data[mesh->num_vertices++] = vertex;
+    }
+    for (usize f = 0; f < quad_template->num_faces; ++f) {
+      mesh->face_normals[mesh->num_faces++] = quad_template->face_normals[f];
+    }
+  }
+
+  mesh->vertex_shader = &billboard_vs;
+  mesh->disable_behind_camera_culling = true;
+  return 0;
+}
+
+// Bounds are in the same space as the tree's vertices, base is where the sprite's origin lies
+int generate_tree_impostor(tree_impostor_t *impostor, const model_t *tree, float3 base, float3 aabb_min, float3 aabb_max) {
+  if (!impostor || !tree || tree->num_faces == 0) return -1;
+  *impostor = (tree_impostor_t){0};
+
+  float reach_x = fmaxf(fabsf(aabb_min.x - base.x), fabsf(aabb_max.x - base.x));
+  float reach_z = fmaxf(fabsf(aabb_min.z - base.z), fabsf(aabb_max.z - base.z));
+  impostor->half_width = sqrtf(reach_x * reach_x + reach_z * reach_z);
+  impostor->bottom = aabb_min.y - base.y;
+  impostor->height = aabb_max.y - aabb_min.y;
+
+  if (impostor->half_width <= 0.0f || impostor->height <= 0.0f) return -1;
+
+  impostor->sprites = calloc(IMPOSTOR_VIEWS * IMPOSTOR_WIDTH * IMPOSTOR_HEIGHT, sizeof(u32));
+  if (!impostor->sprites) return -1;
+
+  model_t quad_template = {0};
+  generate_quad(&quad_template, make_float2(1.0f, 1.0f), make_float3(0, 0, 0));
+
+  int ret = quad_template.num_vertices > 0 ? 0 : -1;
+  for (usize view = 0; view < IMPOSTOR_VIEWS && ret == 0; ++view) {
+    u32 *sprite = impostor->sprites + view * IMPOSTOR_WIDTH * IMPOSTOR_HEIGHT;
+
+    bake_view(tree, impostor, base, view, sprite);
+    ret = build_silhouette(&impostor->views[view], &quad_template, impostor, sprite);
+  }
+
+  delete_model(&quad_template);
+
+  if (ret != 0) free_tree_impostor(impostor);
+  return ret;
+}
+
+void free_tree_impostor(tree_impostor_t *impostor) {
+  if (!impostor) return;
+
+  for (usize view = 0; view < IMPOSTOR_VIEWS; ++view) {
+    delete_model(&impostor->views[view]);
+  }
+
+  free(impostor->sprites);
+  *impostor = (tree_impostor_t){0};
+}
+
+usize tree_impostor_memory_size(const tree_impostor_t *impostor) {
+  if (!impostor || !impostor->sprites) return 0;
+
+  usize size = IMPOSTOR_VIEWS * IMPOSTOR_WIDTH * IMPOSTOR_HEIGHT * sizeof(u32);
+  for (usize view = 0; view < IMPOSTOR_VIEWS; ++view) {
+    size += impostor->views[view].num_vertices * sizeof(vertex_data_t) + impostor->views[view].num_faces * sizeof(float3);
+  }
+
+  return size;
+}
+
+usize render_tree_impostor(renderer_t *state, transform_t *camera, tree_impostor_t *impostor, const tree_instance_t *instance, light_t *lights, usize num_lights, render_pass_t pass) {
+  if (!impostor || !impostor->sprites || !instance) return 0;
+
+  float3 right, up, forward;
+  transform_get_basis_vectors(camera, &right, &up, &forward);
+
+  // the baked view whose sprite axis lines up best with the camera's right vector, the views were
+  // baked in archetype space so the camera is turned back by the instance's yaw
+  tree_transform_t transform = tree_instance_transform(instance);
+  float3 flat_right = float3_normalize(tree_untransform_direction(&transform, make_float3(right.x, 0.0f, right.z)));
+  usize best_view = 0;
+  float best_dot = -2.0f;
+  for (usize view = 0; view < IMPOSTOR_VIEWS; ++view) {
+    float d = float3_dot(flat_right, view_axis(view));
+    if (d > best_dot) {
+      best_dot = d;
+      best_view = view;
+    }
+  }
+
+  const model_t *view_mesh = &impostor->views[best_view];
+  if (!view_mesh->vertex_data || view_mesh->num_vertices == 0) return 0;
+
+  // the draw, its shaders and the mesh copy live on the stack, nothing of one draw outlives it
+  impostor_draw_t draw = {
+    .impostor = impostor,
+    .sprite = impostor->sprites + best_view * IMPOSTOR_WIDTH * IMPOSTOR_HEIGHT,
+    .base = instance->position,
+    .right = right,
+    .up = up,
+    .scale = transform.scale
+  };
+
+  vertex_shader_t billboard = billboard_vs;
+  billboard.argv = &draw.scale;
+  billboard.argc = sizeof(float);
+
+  fragment_shader_t shader = {
+    .func = pass == RENDER_PASS_VISIBILITY ? impostor_visibility_func : impostor_frag_func,
+    .argv = &draw,
+    .argc = sizeof(impostor_draw_t),
+    .valid = true
+  };
+
+  model_t mesh = *view_mesh;
+  mesh.transform.position = instance->position;
+  mesh.vertex_shader = &billboard;
+  mesh.frag_shader = &shader;
+  return render_model(state, camera, &mesh, lights, num_lights);
+}
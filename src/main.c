@@ -1,24 +1,33 @@
 #include <shader-works/renderer.h>
 
 #include <assert.h>
-#include <float.h> // FLT_MAX
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <SDL3/SDL.h>
 
+#include "util/chunk_store.h"
+#include "util/color.h"
 #include "util/config.h"
+#include "util/perf.h"
+#include "util/post_pass.h"
+#include "util/profiler.h"
+#include "util/projection.h"
 #include "util/state.h"
 #include "scene.h"
 
 // Default values
 #define MAX_DEPTH 40
+#define DEFAULT_BENCH_FRAMES 600
+#define DEFAULT_CHUNK_MAP_BENCH_LOOKUPS 20000000
 
 typedef enum {
   GENERATE,
   NORMAL,
   OVERHEAD,
+  BENCH,
   NUM_STATES
 } state;
 
@@ -29,17 +38,42 @@ typedef struct {
   uint64_t last_counter_time;
 } performance_counter;
 
+// Render thread of pipelined mode, it draws frame N's snapshot while the main thread ticks N + 1.
+// Experimental, off by default: whether render_model may run alongside other shader-works calls has
+// not been checked against the library. The ticks keep to the value-in value-out maths helpers
+// while it runs, update_camera waits for prepare_view (see aim_camera), everything else that
+// reaches into shader-works happens on the main thread between finish_render and start_render
+typedef struct {
+  SDL_Thread *thread;
+  SDL_Semaphore *start, *done;
+  bool quit;
+  usize triangles;    // rendered by the last frame
+} render_pipeline_t;
+
 struct context_t {
   u32 *framebuffer;
   f32 *depth_buffer;
+  u32 *present_buffer;  // post pass target when there is no texture to write into
 
   renderer_t renderer;
   scene_t scene;
   const bool *keys;
 
+  // What the render callbacks draw: the scene and renderer themselves, or in pipelined mode a
+  // snapshot of them taken before the ticks that now run alongside the render
+  scene_t *view;
+  renderer_t *view_renderer;
+  float view_time;
+  fog_t view_fog;     // set by the render callbacks, applied by present_frame
+  scene_t snapshot;
+  renderer_t snapshot_renderer;
+  render_pipeline_t pipeline;
+
   float total_time;
+  usize bench_tick;   // ticks elapsed along the benchmark camera path
 
   state_machine_t *sm;
+  bool benchmark;
 };
 
 static const float TICK_RATE = 20.0f; // 20 TPS
@@ -104,6 +138,17 @@ static void get_fog_color(float time_elapsed, u8 *r, u8 *g, u8 *b) {
   get_cycle_color(time_elapsed, fog_colors, r, g, b);
 }
 
+// Fog of the first person view, from halfway to max_depth until just before it
+static fog_t view_fog(const renderer_t *renderer, u32 color) {
+  return (fog_t){ .enabled = true, .start = renderer->max_depth / 2.f, .end = renderer->max_depth - 1.0f, .color = color };
+}
+
+// Ticks aim the renderer at the camera they moved. Pipelined, prepare_view does it for the snapshot
+// before the render starts, so no tick calls update_camera while render_model may be running
+static void aim_camera(struct context_t *ctx) {
+  if (!ctx->pipeline.thread) update_camera(&ctx->renderer, &ctx->scene.camera_pos);
+}
+
 static void apply_fps_movement(struct context_t *ctx, float dt) {
   const bool *keys = ctx->keys;
   float3 movement = {0}, right, up, forward;
@@ -119,7 +164,7 @@ static void apply_fps_movement(struct context_t *ctx, float dt) {
   
   // apply movement
   ctx->scene.camera_pos.position = float3_add(ctx->scene.camera_pos.position, movement);
-  float new_ground_height = get_interpolated_terrain_height(ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z);
+  float new_ground_height = get_terrain_height(&ctx->scene.chunk_map, ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z);
 
   // mouse input
   float mx, my;
@@ -132,7 +177,7 @@ static void apply_fps_movement(struct context_t *ctx, float dt) {
   if (ctx->scene.camera_pos.pitch > ctx->scene.controller.max_pitch) ctx->scene.camera_pos.pitch = ctx->scene.controller.max_pitch;
 
   ctx->scene.controller.ground_height = new_ground_height;
-  update_camera(&ctx->renderer, &ctx->scene.camera_pos);
+  aim_camera(ctx);
 }
 
 static void on_generate(void *args, size_t size) {
@@ -163,7 +208,7 @@ static void on_generate(void *args, size_t size) {
   ctx->scene.controller.ground_height = terrain_height;
   ctx->scene.camera_pos.position.y = terrain_height + ctx->scene.controller.camera_height_offset;
 
-  fsm_change_state(ctx->sm, NORMAL);
+  fsm_change_state(ctx->sm, ctx->benchmark ? BENCH : NORMAL);
 }
 
 static void on_normal_enter(void *args, size_t size) {
@@ -182,40 +227,71 @@ static void on_normal_enter(void *args, size_t size) {
   ctx->renderer.wireframe_mode = false;
 
   // Update camera with current position
-  update_camera(&ctx->renderer, &ctx->scene.camera_pos);
+  aim_camera(ctx);
 }
 
-static void on_normal_tick(void *args, size_t size, float dt) {
-  (void)size; // unused
-  if (!args) return;
+// Shadow masks are rebuilt in place, so in pipelined mode they wait for finish_render instead.
+// The benchmark waits for the chunks it requested so every run renders the same ones
+static void update_chunks(struct context_t *ctx) {
+  update_loaded_chunks(&ctx->scene);
+  if (ctx->benchmark) finish_chunk_loads(&ctx->scene);
+  if (!ctx->pipeline.thread) update_shadow_masks(&ctx->scene);
+}
 
-  struct context_t *ctx = (struct context_t*)args;
-  
-  // apply movement
-  apply_fps_movement(ctx, dt);
+// Everything a first person tick does after the camera has been moved
+static void update_world(struct context_t *ctx) {
   ctx->scene.camera_pos.position.y = ctx->scene.controller.ground_height + ctx->scene.controller.camera_height_offset;
 
   // update snow particles
-  update_quads(ctx->scene.camera_pos.position, &ctx->scene.camera_pos);
+  update_quads(ctx->scene.camera_pos.position, &ctx->scene.camera_pos, &ctx->scene.chunk_map);
 
   // update loaded chunks
-  update_loaded_chunks(&ctx->scene);
+  update_chunks(ctx);
 
   ctx->scene.sun.color = get_sun_color(ctx->total_time);
 }
 
+static void on_normal_tick(void *args, size_t size, float dt) {
+  (void)size; // unused
+  if (!args) return;
+
+  struct context_t *ctx = (struct context_t*)args;
+  
+  // apply movement
+  apply_fps_movement(ctx, dt);
+  update_world(ctx);
+}
+
 static int on_normal_render(void *args, size_t size) {
   (void)size; // unused
   if (!args) return 0;
 
   struct context_t *ctx = (struct context_t*)args;
 
-  usize triangles_rendered = render_loaded_chunks(&ctx->renderer, &ctx->scene, &ctx->scene.sun, 1);
-  triangles_rendered += render_quads(&ctx->renderer, &ctx->scene.camera_pos, &ctx->scene.sun, 1);
+  // deferred shading draws everything into the visibility buffer first and shades it in one pass
+  render_pass_t pass = g_world_config.deferred_shading ? RENDER_PASS_VISIBILITY : RENDER_PASS_FORWARD;
+
+  profiler_begin(PROFILE_RENDER_CHUNKS);
+  usize triangles_rendered = render_loaded_chunks(ctx->view_renderer, ctx->view, &ctx->view->sun, 1, pass);
+  profiler_end(PROFILE_RENDER_CHUNKS);
+
+  profiler_begin(PROFILE_RENDER_QUADS);
+  render_quads(ctx->view_renderer, &ctx->view->camera_pos, pass);
+  profiler_end(PROFILE_RENDER_QUADS);
 
+  if (pass == RENDER_PASS_VISIBILITY) {
+    profiler_begin(PROFILE_RESOLVE);
+    resolve_visibility_buffer(ctx->view_renderer, ctx->view, &ctx->view->sun, 1);
+    profiler_end(PROFILE_RESOLVE);
+  }
+
+  ctx->view->stats.fragments_shaded += take_shaded_fragments();
+  ctx->view->stats.pixels_covered += count_covered_pixels(ctx->view_renderer);
+
+  // applied by present_frame in the same pass that clears the buffers for the next frame
   u8 fog_r, fog_g, fog_b;
-  get_fog_color(ctx->total_time, &fog_r, &fog_g, &fog_b);
-  apply_fog_to_screen(&ctx->renderer, ctx->renderer.max_depth / 2.f, ctx->renderer.max_depth - 1.0f, fog_r, fog_g, fog_b);
+  get_fog_color(ctx->view_time, &fog_r, &fog_g, &fog_b);
+  ctx->view_fog = view_fog(ctx->view_renderer, rgb_to_u32(fog_r, fog_g, fog_b));
 
   return triangles_rendered;
 }
@@ -253,8 +329,8 @@ static void on_overhead_tick(void *args, size_t size, float dt) {
   if (keys[SDL_SCANCODE_D]) movement = float3_add(movement, float3_scale(world_right, -speed));
 
   ctx->scene.camera_pos.position = float3_add(ctx->scene.camera_pos.position, movement);
-  update_loaded_chunks(&ctx->scene);
-  update_camera(&ctx->renderer, &ctx->scene.camera_pos);
+  update_chunks(ctx);
+  aim_camera(ctx);
 }
 
 static int on_overhead_render(void *args, size_t size) {
@@ -264,11 +340,54 @@ static int on_overhead_render(void *args, size_t size) {
   struct context_t *ctx = (struct context_t*)args;
   
   model_t cube = { 0 };
-  float3 pos = make_float3(ctx->scene.camera_pos.position.x, ctx->scene.controller.ground_height + ctx->scene.controller.camera_height_offset, ctx->scene.camera_pos.position.z);
+  float3 pos = make_float3(ctx->view->camera_pos.position.x, ctx->view->controller.ground_height + ctx->view->controller.camera_height_offset, ctx->view->camera_pos.position.z);
   generate_cube(&cube, pos, (float3){ 2, 1, 2 });
 
-  usize triangles_rendered = render_loaded_chunks(&ctx->renderer, &ctx->scene, &ctx->scene.sun, 1);
-  return triangles_rendered + render_model(&ctx->renderer, &ctx->scene.camera_pos, &cube, &ctx->scene.sun, 1);
+  profiler_begin(PROFILE_RENDER_CHUNKS);
+  usize triangles_rendered = render_loaded_chunks(ctx->view_renderer, ctx->view, &ctx->view->sun, 1, RENDER_PASS_FORWARD);
+  profiler_end(PROFILE_RENDER_CHUNKS);
+
+  ctx->view->stats.fragments_shaded += take_shaded_fragments();
+  ctx->view->stats.pixels_covered += count_covered_pixels(ctx->view_renderer);
+  ctx->view_fog = (fog_t){ .enabled = false };
+
+  return triangles_rendered + render_model(ctx->view_renderer, &ctx->view->camera_pos, &cube, &ctx->view->sun, 1);
+}
+
+static void on_bench_enter(void *args, size_t size) {
+  (void)size; // unused
+  if (!args) return;
+
+  struct context_t *ctx = (struct context_t*)args;
+
+  // Same snow every run
+  srand(0);
+  ctx->bench_tick = 0;
+
+  on_normal_enter(args, size);
+}
+
+// Deterministic flythrough: a wide loop that keeps crossing chunk borders while turning,
+// so every run generates, evicts and renders the same chunks in the same order
+static void on_bench_tick(void *args, size_t size, float dt) {
+  (void)size; // unused
+  if (!args) return;
+
+  struct context_t *ctx = (struct context_t*)args;
+
+  const float radius = 96.0f;
+  float angle = (float)ctx->bench_tick * dt * ctx->scene.controller.move_speed / radius;
+
+  ctx->scene.camera_pos.position.x = radius * sinf(angle);
+  ctx->scene.camera_pos.position.z = -radius * (1.0f - cosf(angle));
+  ctx->scene.camera_pos.yaw = -angle;
+  ctx->scene.camera_pos.pitch = 0.0f;
+
+  ctx->scene.controller.ground_height = get_terrain_height(&ctx->scene.chunk_map, ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z);
+  aim_camera(ctx);
+
+  update_world(ctx);
+  ctx->bench_tick++;
 }
 
 static state_interface_t generate = {
@@ -292,8 +411,239 @@ static state_interface_t overhead = {
   .exit = NULL
 };
 
+static state_interface_t bench = {
+  .enter = on_bench_enter,
+  .tick = on_bench_tick,
+  .render = on_normal_render,
+  .exit = NULL
+};
+
+static u32 get_background_color(float time_elapsed) {
+  u8 r, g, b;
+  get_fog_color(time_elapsed, &r, &g, &b);
+  return rgb_to_u32(r, g, b);
+}
+
+// Fog, copy into out and clear for the next frame, all in one pass over the frame just rendered.
+// Runs on the main thread once the frame is finished, before the next one starts drawing
+static void present_frame(struct context_t *ctx, u32 *out, usize out_stride) {
+  profiler_begin(PROFILE_POST);
+  post_process_frame(&ctx->renderer, &ctx->view_fog, get_background_color(ctx->view_time), out, out_stride);
+  profiler_end(PROFILE_POST);
+}
+
+// Point the render callbacks at what this frame draws. Pipelined, that is a snapshot taken now,
+// so the ticks that follow can change the scene while it is being drawn
+static void prepare_view(struct context_t *ctx) {
+  snapshot_quads();
+  ctx->view_time = ctx->total_time;
+
+  if (!ctx->pipeline.thread) {
+    ctx->view = &ctx->scene;
+    ctx->view_renderer = &ctx->renderer;
+    return;
+  }
+
+  snapshot_scene(&ctx->snapshot, &ctx->scene);
+  ctx->snapshot_renderer = ctx->renderer;
+  update_camera(&ctx->snapshot_renderer, &ctx->snapshot.camera_pos);
+  ctx->view = &ctx->snapshot;
+  ctx->view_renderer = &ctx->snapshot_renderer;
+}
+
+// The buffers were cleared by the previous frame's present_frame
+static usize render_view(struct context_t *ctx) {
+  return fsm_render_state(ctx->sm);
+}
+
+static int render_thread(void *data) {
+  struct context_t *ctx = (struct context_t*)data;
+
+  while (true) {
+    SDL_WaitSemaphore(ctx->pipeline.start);
+    if (ctx->pipeline.quit) break;
+
+    ctx->pipeline.triangles = render_view(ctx);
+    SDL_SignalSemaphore(ctx->pipeline.done);
+  }
+
+  return 0;
+}
+
+// Starts the render thread, without it every frame renders on the main thread after its ticks
+static void init_render_pipeline(struct context_t *ctx) {
+  render_pipeline_t *pipeline = &ctx->pipeline;
+
+  if (init_scene_snapshot(&ctx->snapshot, &ctx->scene) != 0) {
+    printf("Failed to allocate the scene snapshot, rendering after each tick instead\n");
+    free_scene_snapshot(&ctx->snapshot);
+    return;
+  }
+
+  pipeline->start = SDL_CreateSemaphore(0);
+  pipeline->done = SDL_CreateSemaphore(0);
+  pipeline->quit = false;
+  pipeline->thread = SDL_CreateThread(render_thread, "render", ctx);
+
+  if (!pipeline->thread) {
+    printf("Failed to start the render thread: %s\n", SDL_GetError());
+    SDL_DestroySemaphore(pipeline->start);
+    SDL_DestroySemaphore(pipeline->done);
+    free_scene_snapshot(&ctx->snapshot);
+    *pipeline = (render_pipeline_t){0};
+  }
+}
+
+static void free_render_pipeline(struct context_t *ctx) {
+  render_pipeline_t *pipeline = &ctx->pipeline;
+  if (!pipeline->thread) return;
+
+  pipeline->quit = true;
+  SDL_SignalSemaphore(pipeline->start);
+  SDL_WaitThread(pipeline->thread, NULL);
+
+  SDL_DestroySemaphore(pipeline->start);
+  SDL_DestroySemaphore(pipeline->done);
+  free_scene_snapshot(&ctx->snapshot);
+  *pipeline = (render_pipeline_t){0};
+}
+
+// Hands the state left by the previous ticks to the render thread
+static void start_render(struct context_t *ctx) {
+  prepare_view(ctx);
+
+  // chunks the ticks evict stay readable until finish_render
+  chunk_arena_pool_defer_reuse(true);
+  SDL_SignalSemaphore(ctx->pipeline.start);
+}
+
+// Waits for the frame started by start_render, then does the scene work that had to wait for it
+static usize finish_render(struct context_t *ctx) {
+  SDL_WaitSemaphore(ctx->pipeline.done);
+  chunk_arena_pool_defer_reuse(false);
+
+  scene_stats_t *view_stats = &ctx->snapshot.stats;
+  scene_stats_t *stats = &ctx->scene.stats;
+  stats->chunks_drawn += view_stats->chunks_drawn;
+  stats->chunks_culled += view_stats->chunks_culled;
+  stats->chunks_occluded += view_stats->chunks_occluded;
+  stats->trees_drawn += view_stats->trees_drawn;
+  stats->trees_culled += view_stats->trees_culled;
+  stats->trees_occluded += view_stats->trees_occluded;
+  stats->hiz_checked += view_stats->hiz_checked;
+  stats->hiz_misses += view_stats->hiz_misses;
+  stats->fragments_shaded += view_stats->fragments_shaded;
+  stats->pixels_covered += view_stats->pixels_covered;
+  *view_stats = (scene_stats_t){ 0 };
+
+  update_shadow_masks(&ctx->scene);
+  return ctx->pipeline.triangles;
+}
+
+// Headless run: one fixed tick per frame, no window, frames are presented into present_buffer
+static void run_benchmark(struct context_t *ctx, state_machine_t *sm, usize num_frames, unsigned int width, unsigned int height) {
+  float *frame_times = calloc(num_frames, sizeof(float));
+  float *tick_times = calloc(num_frames, sizeof(float));
+  uint64_t total_triangles = 0;
+
+  if (!frame_times || !tick_times) {
+    printf("Failed to allocate benchmark samples\n");
+    free(frame_times);
+    free(tick_times);
+    return;
+  }
+
+  ctx->scene.stats = (scene_stats_t){ 0 };
+
+  for (usize frame = 0; frame < num_frames; ++frame) {
+    uint64_t frame_start = SDL_GetPerformanceCounter();
+    profiler_frame_begin();
+
+    if (ctx->pipeline.thread) start_render(ctx);
+
+    ctx->total_time += TICK_INTERVAL;
+    profiler_begin(PROFILE_TICK);
+    fsm_tick_state(sm, TICK_INTERVAL);
+    profiler_end(PROFILE_TICK);
+    uint64_t tick_end = SDL_GetPerformanceCounter();
+
+    if (ctx->pipeline.thread) {
+      total_triangles += finish_render(ctx);
+    } else {
+      prepare_view(ctx);
+      total_triangles += render_view(ctx);
+    }
+
+    present_frame(ctx, ctx->present_buffer, width);
+
+    profiler_frame_end();
+    uint64_t frame_end = SDL_GetPerformanceCounter();
+    frame_times[frame] = perf_elapsed_ms(frame_start, frame_end);
+    tick_times[frame] = perf_elapsed_ms(frame_start, tick_end);
+  }
+
+  perf_summary_t frame_summary, tick_summary;
+  perf_summarize(frame_times, num_frames, &frame_summary);
+  perf_summarize(tick_times, num_frames, &tick_summary);
+
+  float chunk_gen_ms = perf_elapsed_ms(0, ctx->scene.stats.chunk_gen_time);
+  usize chunks_generated = ctx->scene.stats.chunks_generated;
+
+  printf("Benchmark: %zu frames @ %ux%u%s\n", num_frames, width, height, ctx->pipeline.thread ? ", pipelined" : "");
+  printf("  frame: min %.3f ms, avg %.3f ms, p99 %.3f ms, max %.3f ms\n",
+         frame_summary.min, frame_summary.avg, frame_summary.p99, frame_summary.max);
+  printf("  tick:  min %.3f ms, avg %.3f ms, p99 %.3f ms, max %.3f ms\n",
+         tick_summary.min, tick_summary.avg, tick_summary.p99, tick_summary.max);
+  printf("  chunk generation: %zu chunks, %.3f ms total, %.3f ms/chunk, %zu reused from cache\n",
+         chunks_generated, chunk_gen_ms, chunks_generated > 0 ? chunk_gen_ms / (float)chunks_generated : 0.0f,
+         ctx->scene.stats.chunks_reused);
+  printf("  triangles/frame: %lu\n", (unsigned long)(total_triangles / num_frames));
+  printf("  shading: %.3f fragments shaded per covered pixel (%s)\n",
+         ctx->scene.stats.pixels_covered > 0 ? (double)ctx->scene.stats.fragments_shaded / (double)ctx->scene.stats.pixels_covered : 0.0,
+         g_world_config.deferred_shading ? "deferred" : "forward");
+  printf("  culling/frame: %.1f chunks drawn, %.1f culled, %.1f occluded, %.1f trees drawn, %.1f culled, %.1f occluded\n",
+         (float)ctx->scene.stats.chunks_drawn / (float)num_frames, (float)ctx->scene.stats.chunks_culled / (float)num_frames,
+         (float)ctx->scene.stats.chunks_occluded / (float)num_frames, (float)ctx->scene.stats.trees_drawn / (float)num_frames,
+         (float)ctx->scene.stats.trees_culled / (float)num_frames, (float)ctx->scene.stats.trees_occluded / (float)num_frames);
+  if (g_world_config.hiz_verify) {
+    printf("  hi-z check: %zu occluded draws redrawn over the occluders' depth, %zu were not hidden\n",
+           ctx->scene.stats.hiz_checked, ctx->scene.stats.hiz_misses);
+  }
+  printf("  terrain batch: %s (max error %g vs scalar terrainHeight)\n",
+         terrain_batch_max_error() == 0.0f ? "enabled" : "disabled, heights use terrainHeight", terrain_batch_max_error());
+  usize arenas_created, arenas_recycled;
+  chunk_arena_pool_stats(&arenas_created, &arenas_recycled);
+  printf("  chunk arenas: %zu created, %zu recycled\n", arenas_created, arenas_recycled);
+  printf("  chunk store: disabled, every chunk is generated\n");
+  printf("  tree library: %.1f KB shared by all chunks\n", (float)tree_library_memory_size() / 1024.0f);
+  profiler_print_summary();
+
+  free(frame_times);
+  free(tick_times);
+}
+
 int main(int argc, char const *argv[]) {
-  (void)argc; (void)argv;
+  // --bench [frames] runs a headless, deterministic flythrough and prints frame timings
+  // --profile-csv <path> dumps the profiler ring buffer on exit
+  // --bench-chunk-map times chunk map lookups and exits
+  bool benchmark = false;
+  bool chunk_map_benchmark = false;
+  usize bench_frames = DEFAULT_BENCH_FRAMES;
+  const char *profile_csv_path = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--bench") == 0) {
+      benchmark = true;
+
+      if (i + 1 < argc && atoi(argv[i + 1]) > 0) {
+        bench_frames = (usize)atoi(argv[++i]);
+      }
+    } else if (strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc) {
+      profile_csv_path = argv[++i];
+    } else if (strcmp(argv[i], "--bench-chunk-map") == 0) {
+      chunk_map_benchmark = true;
+    }
+  }
 
   // Load window configuration from config.json
   unsigned int config_width, config_height, config_scale;
@@ -301,23 +651,44 @@ int main(int argc, char const *argv[]) {
 
   load_config(&config_width, &config_height, &config_scale, config_title, sizeof(config_title));
   load_world_config();
+  load_profiler_config();
+
+  // a warm store would make a benchmark run depend on the ones before it
+  if (benchmark) g_world_config.chunk_store_dir[0] = '\0';
+
+  if (chunk_map_benchmark) {
+    printf("Chunk map benchmark: %d x %d resident chunks\n", g_world_config.resident_width, g_world_config.resident_width);
+    run_chunk_map_benchmark(DEFAULT_CHUNK_MAP_BENCH_LOOKUPS);
+    free_config();
+    return 0;
+  }
+
+  // shaders pack pixels with the layout in util/color.h instead of asking SDL on every call
+  if (!check_color_format()) {
+    free_config();
+    return 1;
+  }
 
-  SDL_Window *sdl_window;
-  SDL_Renderer *sdl_renderer;
-  SDL_Texture *sdl_framebuff;
+  SDL_Window *sdl_window = NULL;
+  SDL_Renderer *sdl_renderer = NULL;
+  SDL_Texture *sdl_framebuff = NULL;
 
   u32 *framebuffer = (u32 *)malloc(config_width * config_height * sizeof(u32));
   f32 *depth_buffer = (f32 *)malloc(config_width * config_height * sizeof(f32));
+  u32 *present_buffer = (u32 *)malloc(config_width * config_height * sizeof(u32));
 
-  // Initialize state and window
-  SDL_library_init(&sdl_window, &sdl_renderer, &sdl_framebuff, config_title, config_width, config_height, config_scale);
-  SDL_SetWindowRelativeMouseMode(sdl_window, true);
+  // Initialize state and window, the benchmark renders offscreen only
+  if (!benchmark) {
+    SDL_library_init(&sdl_window, &sdl_renderer, &sdl_framebuff, config_title, config_width, config_height, config_scale);
+    SDL_SetWindowRelativeMouseMode(sdl_window, true);
+  }
 
   renderer_t renderer = {0};
   init_renderer(&renderer, config_width, config_height, 0, 0, framebuffer, depth_buffer, MAX_DEPTH);
 
   performance_counter stats;
   init_performance_counter(&stats);
+  profiler_init(g_profiler_config.history_frames, g_profiler_config.frame_budget_ms);
 
   // Initialize state machine
   state_machine_t sm = {0};
@@ -326,25 +697,41 @@ int main(int argc, char const *argv[]) {
   struct context_t state_context = {
     .framebuffer = framebuffer,
     .depth_buffer = depth_buffer,
+    .present_buffer = present_buffer,
     .renderer = renderer,
 
-    .keys = SDL_GetKeyboardState(NULL),
+    .keys = benchmark ? NULL : SDL_GetKeyboardState(NULL),
     .sm = &sm,
-    .total_time = 0.0f
+    .total_time = 0.0f,
+    .benchmark = benchmark
   };
 
   fsm_set_state_interface(&sm, GENERATE, &generate);
   fsm_set_state_interface(&sm, NORMAL, &normal);
   fsm_set_state_interface(&sm, OVERHEAD, &overhead);
+  fsm_set_state_interface(&sm, BENCH, &bench);
 
   fsm_update_internal_state(&sm, &state_context, sizeof(struct context_t));
   fsm_start(&sm);
 
-  bool running = true;
+  if (g_world_config.pipelined_rendering) {
+    printf("Pipelined rendering is experimental, render_model runs on its own thread alongside the ticks\n");
+    init_render_pipeline(&state_context);
+  }
+
+  // from here on present_frame leaves the buffers cleared for the next frame
+  clear_frame_buffers(&state_context.renderer, get_background_color(state_context.total_time));
+
+  bool running = !benchmark;
+  if (benchmark) {
+    run_benchmark(&state_context, &sm, bench_frames, config_width, config_height);
+  }
+
   float accumulator = 0.0f;
   uint64_t last_time = SDL_GetPerformanceCounter();
 
   while (running) {
+    profiler_frame_begin();
     uint64_t current_time = SDL_GetPerformanceCounter();
     float frame_time = (float)(current_time - last_time) / (float)SDL_GetPerformanceFrequency();
     last_time = current_time;
@@ -372,37 +759,62 @@ int main(int argc, char const *argv[]) {
       }
     }
 
+    // pipelined, the ticks below run while the render thread draws the state the previous ones left
+    if (state_context.pipeline.thread) start_render(&state_context);
+
     // Fixed timestep game updates
     while (accumulator >= TICK_INTERVAL) {
+      profiler_begin(PROFILE_TICK);
       fsm_tick_state(&sm, TICK_INTERVAL);
+      profiler_end(PROFILE_TICK);
 
       accumulator -= TICK_INTERVAL;
       stats.tps_counter++;
     }
 
-    u8 bg_r, bg_g, bg_b;
-    get_fog_color(state_context.total_time, &bg_r, &bg_g, &bg_b);
-    u32 background_color = rgb_to_u32(bg_r, bg_g, bg_b);
-
-    for(int i = 0; i < config_width * config_height; ++i) {
-      framebuffer[i] = background_color;
-      depth_buffer[i] = FLT_MAX;
+    if (state_context.pipeline.thread) {
+      stats.triangle_counter += finish_render(&state_context);
+    } else {
+      prepare_view(&state_context);
+      stats.triangle_counter += render_view(&state_context);
     }
 
-    fsm_render_state(&sm);
+    // the post pass writes straight into the streaming texture, or into present_buffer and a copy
+    // when the texture can't be locked
+    void *pixels = NULL;
+    int pitch = 0;
+    if (SDL_LockTexture(sdl_framebuff, NULL, &pixels, &pitch) && pixels && pitch > 0) {
+      present_frame(&state_context, (u32 *)pixels, (usize)pitch / sizeof(u32));
+      SDL_UnlockTexture(sdl_framebuff);
+    } else {
+      if (pixels) SDL_UnlockTexture(sdl_framebuff);
+      present_frame(&state_context, present_buffer, config_width);
+      SDL_UpdateTexture(sdl_framebuff, NULL, present_buffer, config_width * sizeof(u32));
+    }
 
-    SDL_UpdateTexture(sdl_framebuff, NULL, framebuffer, config_width * sizeof(u32));
+    profiler_begin(PROFILE_PRESENT);
     SDL_RenderTexture(sdl_renderer, sdl_framebuff, NULL, NULL);
     SDL_RenderPresent(sdl_renderer);
-    
+    profiler_end(PROFILE_PRESENT);
+
+    profiler_frame_end();
     stats.fps_counter++;
-    // stats.triangle_counter += triangles_rendered;
     uint64_t counter_time = SDL_GetPerformanceCounter();
     if ((float)(counter_time - stats.last_counter_time) / (float)SDL_GetPerformanceFrequency() >= 1.0f) {
       uint64_t avg_triangles_per_frame = stats.fps_counter > 0 ? stats.triangle_counter / stats.fps_counter : 0;
-      printf("TPS: %lu, FPS: %lu, Triangles/frame: %lu, Player: (%.1f, %.1f, %.1f)\n",
+      scene_stats_t *scene_stats = &state_context.scene.stats;
+      uint64_t frames = stats.fps_counter > 0 ? stats.fps_counter : 1;
+      printf("TPS: %lu, FPS: %lu, Triangles/frame: %lu, Overdraw: %.2f, Chunks drawn/culled/occluded: %lu/%lu/%lu, Trees drawn/culled/occluded: %lu/%lu/%lu, Player: (%.1f, %.1f, %.1f)\n",
               stats.tps_counter, stats.fps_counter, avg_triangles_per_frame,
+              scene_stats->pixels_covered > 0 ? (double)scene_stats->fragments_shaded / (double)scene_stats->pixels_covered : 0.0,
+              (unsigned long)(scene_stats->chunks_drawn / frames), (unsigned long)(scene_stats->chunks_culled / frames),
+              (unsigned long)(scene_stats->chunks_occluded / frames),
+              (unsigned long)(scene_stats->trees_drawn / frames), (unsigned long)(scene_stats->trees_culled / frames),
+              (unsigned long)(scene_stats->trees_occluded / frames),
               state_context.scene.camera_pos.position.x, state_context.scene.camera_pos.position.y, state_context.scene.camera_pos.position.z);
+      scene_stats->chunks_drawn = scene_stats->chunks_culled = scene_stats->chunks_occluded = 0;
+      scene_stats->trees_drawn = scene_stats->trees_culled = scene_stats->trees_occluded = 0;
+      scene_stats->fragments_shaded = scene_stats->pixels_covered = 0;
       stats.tps_counter = 0;
       stats.fps_counter = 0;
       stats.triangle_counter = 0;
@@ -410,16 +822,30 @@ int main(int argc, char const *argv[]) {
     }
   }
 
-  free_chunk_map(&state_context.scene.chunk_map);
+  if (!benchmark) profiler_print_summary();
+
+  usize store_hits = 0, store_misses = 0;
+  if (chunk_store_stats(&store_hits, &store_misses)) {
+    printf("Chunk store: %zu chunks loaded from disk, %zu generated\n", store_hits, store_misses);
+  }
+  if (profile_csv_path) profiler_export_csv(profile_csv_path);
+  profiler_free();
+
+  free_render_pipeline(&state_context);
+  free_scene(&state_context.scene);
+  free_quads();
   fsm_free(&sm);
 
   free(framebuffer);
   free(depth_buffer);
+  free(present_buffer);
 
-  SDL_DestroyTexture(sdl_framebuff);
-  SDL_DestroyRenderer(sdl_renderer);
-  SDL_DestroyWindow(sdl_window);
-  SDL_Quit();
+  if (!benchmark) {
+    SDL_DestroyTexture(sdl_framebuff);
+    SDL_DestroyRenderer(sdl_renderer);
+    SDL_DestroyWindow(sdl_window);
+    SDL_Quit();
+  }
 
   free_config();
 
@@ -0,0 +1,404 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <shader-works/maths.h>
+
+#include "scene.h"
+
+// Batched terrain evaluation. The per-point kernels are vectorized with AVX2 or SSE4.1 when the
+// build enables them (-march=native), otherwise the scalar functions in proc_gen.c are used.
+// Every kernel performs the same float operations in the same order as the scalar path, and this
+// file and proc_gen.c are both built with -ffp-contract=off (see CMakeLists.txt) so neither side
+// fuses multiply-adds. verify_terrain_batch still checks the batch paths reproduce terrainHeight
+// bit for bit before they are used, a build that fuses anyway gets the scalar world.
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NOISE_LANES 8
+
+typedef __m256 vfloat;
+typedef __m256i vint;
+
+static inline vfloat vf_load(const float *p) { return _mm256_loadu_ps(p); }
+static inline void vf_store(float *p, vfloat v) { _mm256_storeu_ps(p, v); }
+static inline vfloat vf_set(float f) { return _mm256_set1_ps(f); }
+static inline vfloat vf_add(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+static inline vfloat vf_sub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+static inline vfloat vf_mul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+static inline vfloat vf_div(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+static inline vfloat vf_floor(vfloat a) { return _mm256_floor_ps(a); }
+static inline vfloat vf_abs(vfloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline vfloat vf_from_int(vint a) { return _mm256_cvtepi32_ps(a); }
+static inline vint vi_from_float(vfloat a) { return _mm256_cvttps_epi32(a); }
+static inline vint vi_set(int i) { return _mm256_set1_epi32(i); }
+static inline vint vi_add(vint a, vint b) { return _mm256_add_epi32(a, b); }
+static inline vint vi_mul(vint a, vint b) { return _mm256_mullo_epi32(a, b); }
+static inline vint vi_xor(vint a, vint b) { return _mm256_xor_si256(a, b); }
+static inline vint vi_and(vint a, vint b) { return _mm256_and_si256(a, b); }
+static inline vint vi_shl13(vint a) { return _mm256_slli_epi32(a, 13); }
+
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define NOISE_LANES 4
+
+typedef __m128 vfloat;
+typedef __m128i vint;
+
+static inline vfloat vf_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void vf_store(float *p, vfloat v) { _mm_storeu_ps(p, v); }
+static inline vfloat vf_set(float f) { return _mm_set1_ps(f); }
+static inline vfloat vf_add(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+static inline vfloat vf_sub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+static inline vfloat vf_mul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+static inline vfloat vf_div(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+static inline vfloat vf_floor(vfloat a) { return _mm_floor_ps(a); }
+static inline vfloat vf_abs(vfloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline vfloat vf_from_int(vint a) { return _mm_cvtepi32_ps(a); }
+static inline vint vi_from_float(vfloat a) { return _mm_cvttps_epi32(a); }
+static inline vint vi_set(int i) { return _mm_set1_epi32(i); }
+static inline vint vi_add(vint a, vint b) { return _mm_add_epi32(a, b); }
+static inline vint vi_mul(vint a, vint b) { return _mm_mullo_epi32(a, b); }
+static inline vint vi_xor(vint a, vint b) { return _mm_xor_si128(a, b); }
+static inline vint vi_and(vint a, vint b) { return _mm_and_si128(a, b); }
+static inline vint vi_shl13(vint a) { return _mm_slli_epi32(a, 13); }
+
+#else
+#define NOISE_LANES 1
+#endif
+
+// Set by verify_terrain_batch, the public entry points fall back to terrainHeight until then
+static bool batch_exact = false;
+static float batch_max_error = 0.0f;
+
+// widest row of lattice columns cached by noise2D_row before falling back to per-point hashing
+#define MAX_ROW_LATTICE 256
+
+static inline float smoothstep_s(float t) {
+  return t * t * (3.0f - 2.0f * t);
+}
+
+#if NOISE_LANES > 1
+// hash2 keeps its arithmetic in 32 bit ints, so the lane version wraps identically
+static inline vfloat hash2_v(vint x, vint y, vint seed_term) {
+  vint n = vi_add(vi_add(x, vi_mul(y, vi_set(57))), seed_term);
+  n = vi_xor(vi_shl13(n), n);
+
+  vint t = vi_add(vi_mul(vi_mul(n, n), vi_set(15731)), vi_set(789221));
+  t = vi_and(vi_add(vi_mul(n, t), vi_set(1376312589)), vi_set(0x7fffffff));
+
+  return vf_sub(vf_set(1.0f), vf_div(vf_from_int(t), vf_set(1073741824.0f)));
+}
+
+static inline vfloat smoothstep_v(vfloat t) {
+  return vf_mul(vf_mul(t, t), vf_sub(vf_set(3.0f), vf_mul(vf_set(2.0f), t)));
+}
+
+static inline vfloat lerp_v(vfloat a, vfloat b, vfloat t) {
+  return vf_add(a, vf_mul(t, vf_sub(b, a)));
+}
+
+static inline vfloat noise2D_v(vfloat x, vfloat y, int seed) {
+  vfloat x_floor = vf_floor(x);
+  vfloat y_floor = vf_floor(y);
+  vint xi = vi_from_float(x_floor);
+  vint yi = vi_from_float(y_floor);
+
+  vfloat xf = vf_sub(x, vf_from_int(xi));
+  vfloat yf = vf_sub(y, vf_from_int(yi));
+
+  vint seed_term = vi_set((int)((unsigned)seed * 2654435761u));
+  vint one = vi_set(1);
+
+  vfloat a = hash2_v(xi, yi, seed_term);
+  vfloat b = hash2_v(vi_add(xi, one), yi, seed_term);
+  vfloat c = hash2_v(xi, vi_add(yi, one), seed_term);
+  vfloat d = hash2_v(vi_add(xi, one), vi_add(yi, one), seed_term);
+
+  vfloat sx = smoothstep_v(xf);
+  vfloat i1 = lerp_v(a, b, sx);
+  vfloat i2 = lerp_v(c, d, sx);
+  return lerp_v(i1, i2, smoothstep_v(yf));
+}
+
+static inline vfloat fbm_v(vfloat x, vfloat y, int octaves, int seed) {
+  vfloat value = vf_set(0.0f);
+  float amplitude = 1.0f;
+  float frequency = 1.0f;
+  float max_value = 0.0f;
+
+  for (int i = 0; i < octaves; i++) {
+    vfloat f = vf_set(frequency);
+    value = vf_add(value, vf_mul(noise2D_v(vf_mul(x, f), vf_mul(y, f), seed + i), vf_set(amplitude)));
+    max_value += amplitude;
+
+    amplitude *= 0.5f;
+    frequency *= 2.0f;
+  }
+
+  return vf_div(value, vf_set(max_value));
+}
+#endif
+
+// fbm for arbitrary points, vector blocks plus a scalar tail
+static void fbm_points(const float *xs, const float *ys, usize count, int octaves, int seed, float *out) {
+  usize i = 0;
+
+#if NOISE_LANES > 1
+  for (; i + NOISE_LANES <= count; i += NOISE_LANES) {
+    vf_store(out + i, fbm_v(vf_load(xs + i), vf_load(ys + i), octaves, seed));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    out[i] = fbm(xs[i], ys[i], octaves, seed);
+  }
+}
+
+// noise2D along a row of increasing x at a single y. Neighbouring samples usually share lattice
+// cells, so the corner hashes are computed once per lattice column instead of four per sample
+static void noise2D_row(const float *xs, usize count, float y, int seed, float *out) {
+  int xi_min = (int)floorf(xs[0]);
+  int xi_max = (int)floorf(xs[count - 1]);
+  int span = xi_max - xi_min + 2;
+
+  if (span > MAX_ROW_LATTICE || span < 2) {
+    for (usize i = 0; i < count; ++i) out[i] = noise2D(xs[i], y, seed);
+    return;
+  }
+
+  int yi = (int)floorf(y);
+  float sy = smoothstep_s(y - (float)yi);
+
+  float row0[MAX_ROW_LATTICE], row1[MAX_ROW_LATTICE];
+  for (int k = 0; k < span; ++k) {
+    row0[k] = hash2(xi_min + k, yi, seed);
+    row1[k] = hash2(xi_min + k, yi + 1, seed);
+  }
+
+  for (usize i = 0; i < count; ++i) {
+    int xi = (int)floorf(xs[i]);
+    int k = xi - xi_min;
+    float sx = smoothstep_s(xs[i] - (float)xi);
+
+    float i1 = lerp(row0[k], row0[k + 1], sx);
+    float i2 = lerp(row1[k], row1[k + 1], sx);
+    out[i] = lerp(i1, i2, sy);
+  }
+}
+
+// fbm along a grid row, xs and y already carry the layer's frequency scale
+static void fbm_row(const float *xs, usize count, float y, int octaves, int seed, float *scratch, float *out) {
+  float amplitude = 1.0f;
+  float frequency = 1.0f;
+  float max_value = 0.0f;
+  float *octave_xs = scratch;
+  float *octave_out = scratch + count;
+
+  for (usize i = 0; i < count; ++i) out[i] = 0.0f;
+
+  for (int o = 0; o < octaves; o++) {
+    for (usize i = 0; i < count; ++i) octave_xs[i] = xs[i] * frequency;
+    noise2D_row(octave_xs, count, y * frequency, seed + o, octave_out);
+
+    for (usize i = 0; i < count; ++i) out[i] += octave_out[i] * amplitude;
+    max_value += amplitude;
+
+    amplitude *= 0.5f;
+    frequency *= 2.0f;
+  }
+
+  for (usize i = 0; i < count; ++i) out[i] = out[i] / max_value;
+}
+
+// Layer outputs of terrainHeight for `count` points, combined by combine_layers
+typedef struct {
+  float *large_hills, *medium_hills, *detail, *warp_x, *warp_y, *mask, *mountains;
+  float *xs, *ys, *scratch;
+} terrain_layers_t;
+
+static bool alloc_layers(terrain_layers_t *layers, usize count) {
+  float *block = malloc(count * 12 * sizeof(float));
+  if (!block) return false;
+
+  layers->large_hills = block;
+  layers->medium_hills = block + count;
+  layers->detail = block + count * 2;
+  layers->warp_x = block + count * 3;
+  layers->warp_y = block + count * 4;
+  layers->mask = block + count * 5;
+  layers->mountains = block + count * 6;
+  layers->xs = block + count * 7;
+  layers->ys = block + count * 8;
+  layers->scratch = block + count * 9;   // 3 * count
+  return true;
+}
+
+static void free_layers(terrain_layers_t *layers) {
+  free(layers->large_hills);
+}
+
+// Mountains sample warped coordinates, which never fall on a grid, so they always go per point
+static void mountain_layer(const float *xs, const float *ys, usize count, int seed, terrain_layers_t *layers) {
+  for (usize i = 0; i < count; ++i) {
+    layers->xs[i] = (xs[i] + layers->warp_x[i]) * 0.004f;
+    layers->ys[i] = (ys[i] + layers->warp_y[i]) * 0.004f;
+  }
+
+  fbm_points(layers->xs, layers->ys, count, 4, seed, layers->mountains);
+}
+
+static void combine_layers(const terrain_layers_t *layers, usize count, float *out) {
+  for (usize i = 0; i < count; ++i) {
+    float mountains = 1.0f - fabsf(layers->mountains[i]);
+    mountains = powf(mountains, 1.5f) * 35.0f;
+
+    float base_terrain = layers->large_hills[i] * 25.0f + (layers->medium_hills[i] * 12.0f) * 0.7f + (layers->detail[i] * 4.0f) * 0.3f;
+    base_terrain -= 8.0f;
+
+    float mountain_mask = smoothstep_s(layers->mask[i] * 0.5f + 0.5f);
+    out[i] = fmaxf(base_terrain + mountains * mountain_mask, 0.0f);
+  }
+}
+
+static void scalar_points(const float *xs, const float *zs, usize count, int seed, float *out) {
+  for (usize i = 0; i < count; ++i) out[i] = terrainHeight(xs[i], zs[i], seed);
+}
+
+static void scalar_grid(float x0, float z0, float step, int nx, int nz, int seed, float *out) {
+  for (int z = 0; z < nz; ++z)
+    for (int x = 0; x < nx; ++x)
+      out[z * nx + x] = terrainHeight(x0 + x * step, z0 + z * step, seed);
+}
+
+static void batch_points(const float *xs, const float *zs, usize count, int seed, float *out) {
+  terrain_layers_t layers;
+  if (!alloc_layers(&layers, count)) {
+    scalar_points(xs, zs, count, seed, out);
+    return;
+  }
+
+  int base_seed = g_world_config.seed + seed;
+
+  // each layer samples (x * scale, z * scale), exactly as terrainHeight does
+  static const struct { float scale; int octaves; int seed_offset; } point_layers[] = {
+    { 0.003f, 4, 0 }, { 0.008f, 5, 1 }, { 0.02f, 6, 2 }, { 0.005f, 3, 3 }, { 0.005f, 3, 4 }, { 0.002f, 3, 6 }
+  };
+  float *layer_out[] = { layers.large_hills, layers.medium_hills, layers.detail, layers.warp_x, layers.warp_y, layers.mask };
+
+  for (usize l = 0; l < sizeof(point_layers) / sizeof(point_layers[0]); ++l) {
+    for (usize i = 0; i < count; ++i) {
+      layers.xs[i] = xs[i] * point_layers[l].scale;
+      layers.ys[i] = zs[i] * point_layers[l].scale;
+    }
+
+    fbm_points(layers.xs, layers.ys, count, point_layers[l].octaves, base_seed + point_layers[l].seed_offset, layer_out[l]);
+  }
+
+  for (usize i = 0; i < count; ++i) {
+    layers.warp_x[i] *= 20.0f;
+    layers.warp_y[i] *= 20.0f;
+  }
+
+  mountain_layer(xs, zs, count, base_seed + 5, &layers);
+  combine_layers(&layers, count, out);
+  free_layers(&layers);
+}
+
+static void batch_grid(float x0, float z0, float step, int nx, int nz, int seed, float *out) {
+  usize count = (usize)nx;
+  terrain_layers_t layers;
+  float *row_xs = malloc(count * 2 * sizeof(float));
+
+  if (!row_xs || !alloc_layers(&layers, count)) {
+    free(row_xs);
+    scalar_grid(x0, z0, step, nx, nz, seed, out);
+    return;
+  }
+
+  float *row_zs = row_xs + count;
+  float *layer_xs = layers.xs;
+  int base_seed = g_world_config.seed + seed;
+
+  static const struct { float scale; int octaves; int seed_offset; } grid_layers[] = {
+    { 0.003f, 4, 0 }, { 0.008f, 5, 1 }, { 0.02f, 6, 2 }, { 0.005f, 3, 3 }, { 0.005f, 3, 4 }, { 0.002f, 3, 6 }
+  };
+  float *layer_out[] = { layers.large_hills, layers.medium_hills, layers.detail, layers.warp_x, layers.warp_y, layers.mask };
+
+  for (int z = 0; z < nz; ++z) {
+    float world_z = z0 + z * step;
+
+    for (usize i = 0; i < count; ++i) {
+      row_xs[i] = x0 + (float)i * step;
+      row_zs[i] = world_z;
+    }
+
+    for (usize l = 0; l < sizeof(grid_layers) / sizeof(grid_layers[0]); ++l) {
+      for (usize i = 0; i < count; ++i) layer_xs[i] = row_xs[i] * grid_layers[l].scale;
+
+      fbm_row(layer_xs, count, world_z * grid_layers[l].scale, grid_layers[l].octaves,
+              base_seed + grid_layers[l].seed_offset, layers.scratch, layer_out[l]);
+    }
+
+    for (usize i = 0; i < count; ++i) {
+      layers.warp_x[i] *= 20.0f;
+      layers.warp_y[i] *= 20.0f;
+    }
+
+    mountain_layer(row_xs, row_zs, count, base_seed + 5, &layers);
+    combine_layers(&layers, count, out + (usize)z * count);
+  }
+
+  free_layers(&layers);
+  free(row_xs);
+}
+
+// terrainHeight(xs[i], zs[i], seed) for every point
+void terrain_height_batch(const float *xs, const float *zs, usize count, int seed, float *out) {
+  if (!xs || !zs || !out || count == 0) return;
+
+  if (batch_exact) batch_points(xs, zs, count, seed, out);
+  else scalar_points(xs, zs, count, seed, out);
+}
+
+// terrainHeight over an nx * nz grid starting at (x0, z0), out is row major in z
+void terrain_height_grid(float x0, float z0, float step, int nx, int nz, int seed, float *out) {
+  if (!out || nx <= 0 || nz <= 0) return;
+
+  if (batch_exact) batch_grid(x0, z0, step, nx, nz, seed, out);
+  else scalar_grid(x0, z0, step, nx, nz, seed, out);
+}
+
+// Compares both batch paths with terrainHeight over a test region, on a lattice aligned grid and on
+// scattered points, and enables them only if every height is identical. Call once the world seed
+// is known and before anything generates terrain
+bool verify_terrain_batch(void) {
+  enum { N = 33 };
+  float grid[N * N], points[N * N], xs[N * N], zs[N * N];
+  float max_error = 0.0f;
+
+  float x0 = -517.0f, z0 = 1283.0f;
+  batch_grid(x0, z0, 1.0f, N, N, g_world_config.seed, grid);
+
+  for (int i = 0; i < N * N; ++i) {
+    xs[i] = x0 + (i % N) * 0.37f;
+    zs[i] = z0 + (i / N) * 0.61f;
+  }
+  batch_points(xs, zs, N * N, g_world_config.seed, points);
+
+  for (int i = 0; i < N * N; ++i) {
+    float grid_error = fabsf(grid[i] - terrainHeight(x0 + (i % N), z0 + (i / N), g_world_config.seed));
+    float point_error = fabsf(points[i] - terrainHeight(xs[i], zs[i], g_world_config.seed));
+
+    if (grid_error > max_error) max_error = grid_error;
+    if (point_error > max_error) max_error = point_error;
+  }
+
+  batch_max_error = max_error;
+  batch_exact = max_error == 0.0f;
+  return batch_exact;
+}
+
+// Largest absolute difference verify_terrain_batch measured, nonzero means the batch paths are off
+float terrain_batch_max_error(void) {
+  return batch_max_error;
+}
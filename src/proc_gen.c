@@ -52,7 +52,7 @@ float noise2D(float x, float y, int seed) {
 }
 
 // Fractal Brownian Motion (fBm) for generating terrain with seed
-static float fbm(float x, float y, int octaves, int seed) {
+float fbm(float x, float y, int octaves, int seed) {
   float value = 0.0f;
   float amplitude = 1.0f;
   float frequency = 1.0f;
@@ -112,6 +112,85 @@ float terrainHeight(float x, float y, int seed) {
   return fmaxf(height, lake_level);
 }
 
+// Bake the terrain heights of a chunk at 1 unit spacing, matching the lattice used by
+// get_interpolated_terrain_height so cached and procedural queries agree exactly
+float *generate_heightfield(chunk_arena_t *arena, int chunk_x, int chunk_z) {
+  int stride = g_world_config.chunk_size + 1;
+  float *heights = chunk_arena_alloc(arena, (usize)stride * stride * sizeof(float));
+  if (!heights) return NULL;
+
+  float origin_x = (float)(chunk_x * g_world_config.chunk_size);
+  float origin_z = (float)(chunk_z * g_world_config.chunk_size);
+
+  terrain_height_grid(origin_x, origin_z, 1.0f, stride, stride, g_world_config.seed, heights);
+  return heights;
+}
+
+// Bilinear height inside cell (local_x, local_z) of a baked heightfield
+static inline float sample_heightfield(const float *heights, int local_x, int local_z, float fx, float fz) {
+  int stride = g_world_config.chunk_size + 1;
+  const float *row0 = heights + local_z * stride + local_x;
+  const float *row1 = row0 + stride;
+
+  float h0 = lerp(row0[0], row0[1], fx);
+  float h1 = lerp(row1[0], row1[1], fx);
+  return lerp(h0, h1, fz);
+}
+
+static inline int floor_div(int a, int b) {
+  int q = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Height at (x, z) from the baked heightfield of the chunk containing it,
+// falls back to evaluating the noise when that chunk is not loaded
+float get_terrain_height(chunk_map_t *map, float x, float z) {
+  int gx = (int)floorf(x);
+  int gz = (int)floorf(z);
+
+  int chunk_x = floor_div(gx, g_world_config.chunk_size);
+  int chunk_z = floor_div(gz, g_world_config.chunk_size);
+
+  chunk_map_node_t *node = map ? chunk_lookup(map, chunk_x, chunk_z) : NULL;
+  if (!node || !node->loaded || !node->chunk.heights) {
+    return get_interpolated_terrain_height(x, z);
+  }
+
+  int local_x = gx - chunk_x * g_world_config.chunk_size;
+  int local_z = gz - chunk_z * g_world_config.chunk_size;
+  return sample_heightfield(node->chunk.heights, local_x, local_z, x - (float)gx, z - (float)gz);
+}
+
+// Bake the ground material of a chunk into a size * size texture, sampled at texel centers.
+// The material only depends on the seed and the terrain height, so the ground shader can
+// fetch it instead of evaluating the ice, gravel and snow noise per pixel every frame
+u32 *generate_ground_albedo(chunk_arena_t *arena, int chunk_x, int chunk_z, const float *heights, int size) {
+  if (size <= 0) return NULL;
+
+  u32 *albedo = chunk_arena_alloc(arena, (usize)size * size * sizeof(u32));
+  if (!albedo) return NULL;
+
+  float texel_size = (float)g_world_config.chunk_size / (float)size;
+  float origin_x = (float)(chunk_x * g_world_config.chunk_size);
+  float origin_z = (float)(chunk_z * g_world_config.chunk_size);
+
+  for (int tz = 0; tz < size; ++tz) {
+    float local_z = ((float)tz + 0.5f) * texel_size;
+    int gz = (int)floorf(local_z);
+
+    for (int tx = 0; tx < size; ++tx) {
+      float local_x = ((float)tx + 0.5f) * texel_size;
+      int gx = (int)floorf(local_x);
+
+      float height = heights ? sample_heightfield(heights, gx, gz, local_x - (float)gx, local_z - (float)gz)
+                             : get_interpolated_terrain_height(origin_x + local_x, origin_z + local_z);
+      albedo[tz * size + tx] = ground_material(origin_x + local_x, origin_z + local_z, height);
+    }
+  }
+
+  return albedo;
+}
+
 float get_interpolated_terrain_height(float x, float z) {
   float grid_size = 1.0f; // Sample every 1 unit
   
@@ -144,176 +223,103 @@ float get_interpolated_terrain_height(float x, float z) {
   return lerp(h0, h1, fz);
 }
 
-// this should append each segment to the model's vertex_data and face_normals
-int generate_tree_cylinder(model_t* model, float bottom_radius, float top_radius, float height, float3 bottom_center, float3 top_center, usize segments, float bottom_angle_offset, float top_angle_offset) {
-  if (!model || segments < 4 || bottom_radius < 0 || top_radius < 0 || height <= 0.001f) return -1;
+// Append a cylinder to mesh. The side shares one ring of vertices at each end between its quads,
+// each cap has its own ring so it keeps a flat normal
+int generate_tree_cylinder(indexed_mesh_t *mesh, float bottom_radius, float top_radius, float height, float3 bottom_center, float3 top_center, usize segments, float bottom_angle_offset, float top_angle_offset) {
+  if (!mesh || segments < 4 || bottom_radius < 0 || top_radius < 0 || height <= 0.001f) return -1;
 
   // Skip degenerate cylinders where both radii are too small
   if (bottom_radius < 0.0001f && top_radius < 0.0001f) return 0;
-  
-  // Calculate vertices and faces
-  usize side_vertices = segments * 6;         // 2 triangles per segment = 6 vertices
-  usize bottom_cap_vertices = (segments - 2) * 3;
-  usize top_cap_vertices = (segments - 2) * 3;
-  usize new_vertices = side_vertices + bottom_cap_vertices + top_cap_vertices;
-  usize new_faces = segments * 2 + (segments - 2) + (segments - 2);
-  
-  usize old_vertices = model->num_vertices;
-  usize old_faces = model->num_faces;
-  
-  // Reallocate arrays for append
-  vertex_data_t* tmp_v = realloc(model->vertex_data, (old_vertices + new_vertices) * sizeof(vertex_data_t));
-  float3* tmp_f = realloc(model->face_normals, (old_faces + new_faces) * sizeof(float3));
-  
-  if (!tmp_v || !tmp_f) {
-    free(tmp_v);
-    free(tmp_f);
-    return -1;
-  }
-  
-  model->vertex_data = tmp_v;
-  model->face_normals = tmp_f;
-  
+
+  bool bottom_cap = bottom_radius > 0.0001f;
+  bool top_cap = top_radius > 0.0001f;
+
+  usize new_vertices = segments * 2 + (bottom_cap ? segments : 0) + (top_cap ? segments : 0);
+  usize new_indices = segments * 6 + ((bottom_cap ? 1 : 0) + (top_cap ? 1 : 0)) * (segments - 2) * 3;
+  if (indexed_mesh_reserve(mesh, new_vertices, new_indices) != 0) return -1;
+
   float3 axis = float3_normalize(float3_sub(top_center, bottom_center));
-  
-  usize vertex_idx = old_vertices;
-  usize face_idx = old_faces;
-  
+
+  // Tangent basis
+  float3 right = float3_normalize(float3_cross(axis, make_float3(0, 1, 0)));
+  if (float3_magnitude(right) < 0.1f)
+    right = float3_normalize(float3_cross(axis, make_float3(1, 0, 0)));
+  float3 forward = float3_normalize(float3_cross(axis, right));
+
+  u16 bottom_ring = (u16)mesh->num_vertices;
+  u16 top_ring = (u16)(bottom_ring + segments);
+  vertex_data_t *ring = mesh->vertices + bottom_ring;
+
   // -------- Side faces --------
   for (usize i = 0; i < segments; i++) {
-    // Bottom angles
-    float angle1b = (2.0f * PI * i) / segments + bottom_angle_offset;
-    float angle2b = (2.0f * PI * (i + 1)) / segments + bottom_angle_offset;
-    
-    float cos1b = cosf(angle1b), sin1b = sinf(angle1b);
-    float cos2b = cosf(angle2b), sin2b = sinf(angle2b);
-    
-    // Top angles
-    float angle1t = (2.0f * PI * i) / segments + top_angle_offset;
-    float angle2t = (2.0f * PI * (i + 1)) / segments + top_angle_offset;
-    
-    float cos1t = cosf(angle1t), sin1t = sinf(angle1t);
-    float cos2t = cosf(angle2t), sin2t = sinf(angle2t);
-    
-    // Tangent basis
-    float3 right = float3_normalize(float3_cross(axis, make_float3(0, 1, 0)));
-    if (float3_magnitude(right) < 0.1f)
-    right = float3_normalize(float3_cross(axis, make_float3(1, 0, 0)));
-    float3 forward = float3_normalize(float3_cross(axis, right));
-    
-    // Bottom vertices
-    float3 bottom1 = float3_add(bottom_center,
-      float3_add(float3_scale(right, cos1b * bottom_radius),
-      float3_scale(forward, sin1b * bottom_radius)));
-      float3 bottom2 = float3_add(bottom_center,
-      float3_add(float3_scale(right, cos2b * bottom_radius),
-      float3_scale(forward, sin2b * bottom_radius)));
-        
-    // Top vertices
-    float3 top1 = float3_add(top_center,
-                  float3_add(float3_scale(right, cos1t * top_radius),
-                  float3_scale(forward, sin1t * top_radius)));
-    float3 top2 = float3_add(top_center,
-                  float3_add(float3_scale(right, cos2t * top_radius),
-                  float3_scale(forward, sin2t * top_radius)));
-      
-    // Side normal
-    float3 edge1 = float3_sub(top1, bottom1);
-    float3 edge2 = float3_sub(bottom2, bottom1);
+    float angle_b = (2.0f * PI * i) / segments + bottom_angle_offset;
+    float angle_t = (2.0f * PI * i) / segments + top_angle_offset;
+
+    float3 bottom = float3_add(bottom_center,
+                    float3_add(float3_scale(right, cosf(angle_b) * bottom_radius),
+                    float3_scale(forward, sinf(angle_b) * bottom_radius)));
+    float3 top = float3_add(top_center,
+                 float3_add(float3_scale(right, cosf(angle_t) * top_radius),
+                 float3_scale(forward, sinf(angle_t) * top_radius)));
+
+    ring[i] = (vertex_data_t){ bottom, make_float2((float)i / segments, 0.0f), make_float3(0, 0, 0) };
+    ring[segments + i] = (vertex_data_t){ top, make_float2((float)i / segments, 1.0f), make_float3(0, 0, 0) };
+  }
+
+  for (usize i = 0; i < segments; i++) {
+    usize next = (i + 1) % segments;
+
+    // Side normal of the quad, shared ring vertices average the normals of both quads they touch
+    float3 edge1 = float3_sub(ring[segments + i].position, ring[i].position);
+    float3 edge2 = float3_sub(ring[next].position, ring[i].position);
     float3 normal = float3_normalize(float3_cross(edge1, edge2));
-    
-    // First triangle
-    model->vertex_data[vertex_idx++] = (vertex_data_t){ bottom1, make_float2((float)i / segments, 0.0f), normal };
-    model->vertex_data[vertex_idx++] = (vertex_data_t){ bottom2, make_float2((float)(i + 1) / segments, 0.0f), normal };
-    model->vertex_data[vertex_idx++] = (vertex_data_t){ top1,    make_float2((float)i / segments, 1.0f), normal };
-    
-    // Second triangle
-    model->vertex_data[vertex_idx++] = (vertex_data_t){ bottom2, make_float2((float)(i + 1) / segments, 0.0f), normal };
-    model->vertex_data[vertex_idx++] = (vertex_data_t){ top2,    make_float2((float)(i + 1) / segments, 1.0f), normal };
-    model->vertex_data[vertex_idx++] = (vertex_data_t){ top1,    make_float2((float)i / segments, 1.0f), normal };
-    
-    model->face_normals[face_idx++] = normal;
-    model->face_normals[face_idx++] = normal;
+
+    ring[i].normal = float3_add(ring[i].normal, normal);
+    ring[next].normal = float3_add(ring[next].normal, normal);
+    ring[segments + i].normal = float3_add(ring[segments + i].normal, normal);
+    ring[segments + next].normal = float3_add(ring[segments + next].normal, normal);
+
+    u16 *tri = mesh->indices + mesh->num_indices;
+    tri[0] = (u16)(bottom_ring + i); tri[1] = (u16)(bottom_ring + next); tri[2] = (u16)(top_ring + i);
+    tri[3] = (u16)(bottom_ring + next); tri[4] = (u16)(top_ring + next); tri[5] = (u16)(top_ring + i);
+    mesh->num_indices += 6;
   }
-  
-  // -------- Bottom cap --------
-  if (bottom_radius > 0.0001f) {
-    float3 bottom_normal = float3_scale(axis, -1.0f);
-    for (usize i = 1; i < segments - 1; i++) {
-      float angle0 = 0 + bottom_angle_offset;
-      float angle1 = (2.0f * PI * i) / segments + bottom_angle_offset;
-      float angle2 = (2.0f * PI * (i + 1)) / segments + bottom_angle_offset;
-      
-      float cos0 = cosf(angle0), sin0 = sinf(angle0);
-      float cos1 = cosf(angle1), sin1 = sinf(angle1);
-      float cos2 = cosf(angle2), sin2 = sinf(angle2);
-      
-      float3 right = float3_normalize(float3_cross(axis, make_float3(0, 1, 0)));
-      if (float3_magnitude(right) < 0.1f)
-      right = float3_normalize(float3_cross(axis, make_float3(1, 0, 0)));
-      float3 forward = float3_normalize(float3_cross(axis, right));
-      
-      float3 v0 = float3_add(bottom_center,
-                  float3_add(float3_scale(right, cos0 * bottom_radius),
-                  float3_scale(forward, sin0 * bottom_radius)));
-      float3 v1 = float3_add(bottom_center,
-                  float3_add(float3_scale(right, cos1 * bottom_radius),
-                  float3_scale(forward, sin1 * bottom_radius)));
-      float3 v2 = float3_add(bottom_center,
-          float3_add(float3_scale(right, cos2 * bottom_radius),
-          float3_scale(forward, sin2 * bottom_radius)));
-          
-          model->vertex_data[vertex_idx++] = (vertex_data_t){ v0, make_float2(0.5f + cos0 * 0.5f, 0.5f + sin0 * 0.5f), bottom_normal };
-          model->vertex_data[vertex_idx++] = (vertex_data_t){ v1, make_float2(0.5f + cos1 * 0.5f, 0.5f + sin1 * 0.5f), bottom_normal };
-          model->vertex_data[vertex_idx++] = (vertex_data_t){ v2, make_float2(0.5f + cos2 * 0.5f, 0.5f + sin2 * 0.5f), bottom_normal };
-          
-          model->face_normals[face_idx++] = bottom_normal;
-    }
+
+  for (usize i = 0; i < segments * 2; i++) {
+    ring[i].normal = float3_normalize(ring[i].normal);
   }
-      
-  // -------- Top cap --------
-  if (top_radius > 0.0001f) {
-    float3 top_normal = axis;
+
+  mesh->num_vertices += segments * 2;
+
+  // -------- Caps --------
+  for (usize cap = 0; cap < 2; cap++) {
+    if ((cap == 0 && !bottom_cap) || (cap == 1 && !top_cap)) continue;
+
+    const vertex_data_t *side = cap == 0 ? ring : ring + segments;
+    float3 cap_normal = cap == 0 ? float3_scale(axis, -1.0f) : axis;
+    u16 first = (u16)mesh->num_vertices;
+
+    for (usize i = 0; i < segments; i++) {
+      float angle = (2.0f * PI * i) / segments + (cap == 0 ? bottom_angle_offset : top_angle_offset);
+      mesh->vertices[first + i] = (vertex_data_t){ side[i].position, make_float2(0.5f + cosf(angle) * 0.5f, 0.5f + sinf(angle) * 0.5f), cap_normal };
+    }
+
+    // fan around the first ring vertex, the top cap's winding is reversed
     for (usize i = 1; i < segments - 1; i++) {
-      float angle0 = 0 + top_angle_offset;
-      float angle1 = (2.0f * PI * i) / segments + top_angle_offset;
-      float angle2 = (2.0f * PI * (i + 1)) / segments + top_angle_offset;
-      
-      float cos0 = cosf(angle0), sin0 = sinf(angle0);
-      float cos1 = cosf(angle1), sin1 = sinf(angle1);
-      float cos2 = cosf(angle2), sin2 = sinf(angle2);
-      
-      float3 right = float3_normalize(float3_cross(axis, make_float3(0, 1, 0)));
-      if (float3_magnitude(right) < 0.1f)
-      right = float3_normalize(float3_cross(axis, make_float3(1, 0, 0)));
-      float3 forward = float3_normalize(float3_cross(axis, right));
-      
-      float3 v0 = float3_add(top_center,
-                  float3_add(float3_scale(right, cos0 * top_radius),
-                  float3_scale(forward, sin0 * top_radius)));
-      float3 v1 = float3_add(top_center,
-                  float3_add(float3_scale(right, cos1 * top_radius),
-                  float3_scale(forward, sin1 * top_radius)));
-      float3 v2 = float3_add(top_center,
-                  float3_add(float3_scale(right, cos2 * top_radius),
-                  float3_scale(forward, sin2 * top_radius)));
-          
-      // Reverse winding
-      model->vertex_data[vertex_idx++] = (vertex_data_t){ v0, make_float2(0.5f + cos0 * 0.5f, 0.5f + sin0 * 0.5f), top_normal };
-      model->vertex_data[vertex_idx++] = (vertex_data_t){ v2, make_float2(0.5f + cos2 * 0.5f, 0.5f + sin2 * 0.5f), top_normal };
-      model->vertex_data[vertex_idx++] = (vertex_data_t){ v1, make_float2(0.5f + cos1 * 0.5f, 0.5f + sin1 * 0.5f), top_normal };
-      
-      model->face_normals[face_idx++] = top_normal;
+      u16 *tri = mesh->indices + mesh->num_indices;
+      tri[0] = first;
+      tri[1] = (u16)(first + (cap == 0 ? i : i + 1));
+      tri[2] = (u16)(first + (cap == 0 ? i + 1 : i));
+      mesh->num_indices += 3;
     }
+
+    mesh->num_vertices += segments;
   }
-      
-  model->num_vertices = old_vertices + new_vertices;
-  model->num_faces = old_faces + new_faces;
-  
+
   return 0;
 }
 
-int generate_tree(model_t *model, float base_radius, float base_angle, float3 base_position, float branch_chance, usize level, const usize max_branches, const usize num_levels, const usize num_side_faces)  {
+int generate_tree(indexed_mesh_t *mesh, float base_radius, float base_angle, float3 base_position, float branch_chance, usize level, const usize max_branches, const usize num_levels, const usize num_side_faces)  {
   static const float base_trunk_height = 8.0f;
   static const float spread_factor = 1.25f;
   float taper_factor = 0.85f;            // Minimal tapering for thick branches
@@ -324,7 +330,7 @@ int generate_tree(model_t *model, float base_radius, float base_angle, float3 ba
   float segment_height, angle_offset;   // angle to aim branches
   float3 top_center;
 
-  if (!model || num_side_faces < 3) {   // base case
+  if (!mesh || num_side_faces < 3) {    // base case
     return -1;
   } else if (level == 0) {              // generate trunk
     segment_height = base_trunk_height;
@@ -349,7 +355,7 @@ int generate_tree(model_t *model, float base_radius, float base_angle, float3 ba
   );
 
   // generate our segment
-  int ret = generate_tree_cylinder(model, base_radius, top_radius, segment_height, base_position, top_center, num_side_faces, base_angle, base_angle);
+  int ret = generate_tree_cylinder(mesh, base_radius, top_radius, segment_height, base_position, top_center, num_side_faces, base_angle, base_angle);
 
   if (level < num_levels - 1 && branch_chance > 0.2f) {
     // Add more variation to number of branches per level
@@ -421,19 +427,149 @@ int generate_tree(model_t *model, float base_radius, float base_angle, float3 ba
       );
 
       float branch_chance_decayed = branch_chance * 0.7;
-      ret += generate_tree(model, growth_base_radius, branch_growth_angle, branch_start, branch_chance_decayed, level + 1, max_branches, num_levels, num_side_faces);
+      ret += generate_tree(mesh, growth_base_radius, branch_growth_angle, branch_start, branch_chance_decayed, level + 1, max_branches, num_levels, num_side_faces);
     }
   }
 
   return ret;
 }
 
-void generate_ground_plane(model_t *model, float2 size, float2 segment_size, float3 position) {
-  generate_plane(model, size, segment_size, position);
-  model->transform = (transform_t){0};
+static inline bool on_border(float a, float b, float border) {
+  return fabsf(a - border) < 1e-3f && fabsf(b - border) < 1e-3f;
+}
+
+// Hang a vertical strip of depth units below every border edge of a ground plane. Neighbouring
+// chunks may use different LOD levels whose border heights disagree between shared vertices,
+// the skirts fill those gaps without either mesh knowing the other's level. The model's arrays must
+// have room for max_faces faces
+static int add_ground_skirts(model_t *model, float2 size, float3 position, float depth, usize max_faces) {
+  float min_x = position.x - size.x * 0.5f, max_x = position.x + size.x * 0.5f;
+  float min_z = position.z - size.y * 0.5f, max_z = position.z + size.y * 0.5f;
+
+  usize num_edges = 0;
+  for (usize f = 0; f < model->num_faces; ++f) {
+    for (usize e = 0; e < 3; ++e) {
+      float3 a = model->vertex_data[f * 3 + e].position;
+      float3 b = model->vertex_data[f * 3 + (e + 1) % 3].position;
+      if (on_border(a.x, b.x, min_x) || on_border(a.x, b.x, max_x) || on_border(a.z, b.z, min_z) || on_border(a.z, b.z, max_z)) num_edges++;
+    }
+  }
+
+  if (num_edges == 0) return 0;
+
+  usize old_faces = model->num_faces;
+  if (old_faces + num_edges * 2 > max_faces) return -1;
+
+  usize face = old_faces;
+  for (usize f = 0; f < old_faces; ++f) {
+    for (usize e = 0; e < 3; ++e) {
+      vertex_data_t a = model->vertex_data[f * 3 + e];
+      vertex_data_t b = model->vertex_data[f * 3 + (e + 1) % 3];
+
+      float3 outward;
+      if (on_border(a.position.x, b.position.x, min_x)) outward = make_float3(-1, 0, 0);
+      else if (on_border(a.position.x, b.position.x, max_x)) outward = make_float3(1, 0, 0);
+      else if (on_border(a.position.z, b.position.z, min_z)) outward = make_float3(0, 0, -1);
+      else if (on_border(a.position.z, b.position.z, max_z)) outward = make_float3(0, 0, 1);
+      else continue;
+
+      vertex_data_t a_low = a, b_low = b;
+      a_low.position.y -= depth;
+      b_low.position.y -= depth;
+
+      // same front face convention as the ground faces, normal = (v2 - v0) x (v1 - v0), facing outward
+      float3 normal = float3_normalize(float3_cross(float3_sub(b_low.position, a.position), float3_sub(b.position, a.position)));
+      if (float3_dot(normal, outward) < 0.0f) {
+        vertex_data_t swap = a; a = b; b = swap;
+        swap = a_low; a_low = b_low; b_low = swap;
+        normal = float3_scale(normal, -1.0f);
+      }
+
+      vertex_data_t quad[6] = { a, b, b_low, a, b_low, a_low };
+      for (usize v = 0; v < 6; ++v) {
+        quad[v].normal = normal;
+        model->vertex_data[face * 3 + v] = quad[v];
+      }
+
+      model->face_normals[face++] = normal;
+      model->face_normals[face++] = normal;
+    }
+  }
+
+  model->num_faces = face;
+  model->num_vertices = face * 3;
+  return 0;
+}
+
+// Faces of a ground plane with segments quads per side, including the skirts along its border
+usize ground_plane_max_faces(usize segments) {
+  return segments * segments * 2 + segments * 4 * 2;
+}
+
+// Flat grid of size.x by size.y centered on position, two triangles per segment facing up
+static int generate_grid(model_t *model, chunk_arena_t *arena, float2 size, float2 segment_size, float3 position, usize max_faces) {
+  usize segments_x = (usize)(size.x / segment_size.x + 0.5f);
+  usize segments_z = (usize)(size.y / segment_size.y + 0.5f);
+  usize num_faces = segments_x * segments_z * 2;
+  if (num_faces == 0 || num_faces > max_faces) return -1;
+
+  model->vertex_data = chunk_arena_alloc(arena, max_faces * 3 * sizeof(vertex_data_t));
+  model->face_normals = chunk_arena_alloc(arena, max_faces * sizeof(float3));
+  if (!model->vertex_data || !model->face_normals) return -1;
+
+  float min_x = position.x - size.x * 0.5f;
+  float min_z = position.z - size.y * 0.5f;
+  vertex_data_t *v = model->vertex_data;
+
+  for (usize iz = 0; iz < segments_z; ++iz) {
+    for (usize ix = 0; ix < segments_x; ++ix) {
+      float x0 = min_x + ix * segment_size.x, x1 = x0 + segment_size.x;
+      float z0 = min_z + iz * segment_size.y, z1 = z0 + segment_size.y;
+      float u0 = (float)ix / segments_x, u1 = (float)(ix + 1) / segments_x;
+      float t0 = (float)iz / segments_z, t1 = (float)(iz + 1) / segments_z;
+
+      vertex_data_t c00 = { make_float3(x0, position.y, z0), make_float2(u0, t0), make_float3(0, 1, 0) };
+      vertex_data_t c10 = { make_float3(x1, position.y, z0), make_float2(u1, t0), make_float3(0, 1, 0) };
+      vertex_data_t c01 = { make_float3(x0, position.y, z1), make_float2(u0, t1), make_float3(0, 1, 0) };
+      vertex_data_t c11 = { make_float3(x1, position.y, z1), make_float2(u1, t1), make_float3(0, 1, 0) };
+
+      // (v2 - v0) x (v1 - v0) points up for both
+      *v++ = c00; *v++ = c10; *v++ = c01;
+      *v++ = c10; *v++ = c11; *v++ = c01;
+    }
+  }
+
+  model->num_faces = num_faces;
+  model->num_vertices = num_faces * 3;
+  return 0;
+}
+
+// Ground geometry is allocated from the chunk's arena. chunk->heights, when baked, is used
+// instead of evaluating the noise per vertex
+void generate_ground_plane(model_t *model, float2 size, float2 segment_size, float3 position, const chunk_t *chunk) {
+  *model = (model_t){0};
+  if (!chunk || !chunk->arena) return;
+
+  usize max_faces = ground_plane_max_faces((usize)(size.x / segment_size.x + 0.5f));
+  if (generate_grid(model, chunk->arena, size, segment_size, position, max_faces) != 0) {
+    *model = (model_t){0};
+    return;
+  }
 
+  int stride = g_world_config.chunk_size + 1;
   for (usize i = 0; i < model->num_vertices; ++i) {
     float3 *v = &model->vertex_data[i].position;
+
+    if (chunk->heights) {
+      int local_x = (int)roundf(v->x) - chunk->x * g_world_config.chunk_size;
+      int local_z = (int)roundf(v->z) - chunk->z * g_world_config.chunk_size;
+
+      if (local_x >= 0 && local_x < stride && local_z >= 0 && local_z < stride) {
+        v->y = chunk->heights[local_z * stride + local_x];
+        continue;
+      }
+    }
+
     v->y = terrainHeight(v->x, v->z, g_world_config.seed);
   }
 
@@ -454,4 +590,7 @@ void generate_ground_plane(model_t *model, float2 size, float2 segment_size, flo
   for (usize i = 0; i < model->num_vertices; ++i) {
     model->vertex_data[i].normal = model->face_normals[i / 3];
   }
+
+  // deep enough for the largest height error of the coarsest LOD
+  add_ground_skirts(model, size, position, g_world_config.ground_segment_size, max_faces);
 }
@@ -4,42 +4,53 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
+#include <float.h>
+#include <string.h>
 
 #include <SDL3/SDL.h>
 #include <shader-works/renderer.h>
 #include <shader-works/maths.h>
 
-extern fragment_shader_t ground_shadow_frag;
-extern fragment_shader_t tree_frag;
+#include "util/profiler.h"
+#include "util/chunk_store.h"
+#include "util/frustum.h"
+#include "util/projection.h"
 
-// Function to set scene data for shadow calculations (defined in shaders.c)
-extern void set_shadow_scene(scene_t *scene);
+extern fragment_shader_t ground_shadow_frag;
+extern fragment_shader_t tree_frag;                 // in shaders.c
+extern fragment_shader_t ground_visibility_frag;    // in deferred.c
+extern fragment_shader_t tree_visibility_frag;      // in deferred.c
 
-extern int generate_tree(model_t *, float, float, float3, float, usize, const usize, const usize, const usize); // in proc_gen.c
-extern void generate_ground_plane(model_t *, float2, float2, float3);                                           // in proc_gen.c
-
-static void generate_chunk(chunk_t *chunk, int chunk_x, int chunk_z) {
-  if (chunk == NULL) return;
-
-  chunk->x = chunk_x;
-  chunk->z = chunk_z;
-  chunk->ground_plane = (model_t){0};
+extern void generate_ground_plane(model_t *, float2, float2, float3, const chunk_t *);                          // in proc_gen.c
+extern usize ground_plane_max_faces(usize);                                                                     // in proc_gen.c
+extern float *generate_heightfield(chunk_arena_t *, int, int);                                                  // in proc_gen.c
+extern u32 *generate_ground_albedo(chunk_arena_t *, int, int, const float *, int);                              // in proc_gen.c
 
+// Scatter the chunk's trees and pick their archetypes, instances come from the chunk's arena
+static void place_trees(chunk_t *chunk, int chunk_x, int chunk_z) {
   float world_x = chunk_x * g_world_config.chunk_size;
   float world_z = chunk_z * g_world_config.chunk_size;
-  float corner_x = world_x;
-  float corner_z = world_z;
 
-  generate_ground_plane(&chunk->ground_plane, make_float2(g_world_config.chunk_size, g_world_config.chunk_size), make_float2(1.0f, 1.0f), make_float3(corner_x + g_world_config.half_chunk_size, 0, corner_z + g_world_config.half_chunk_size));
-  chunk->ground_plane.frag_shader = &ground_shadow_frag;
+  usize num_candidates = map_range(hash2(chunk_x, chunk_z, g_world_config.seed), -1.0f, 1.0f, 0, 7);
+  if (num_candidates > MAX_TREES_PER_CHUNK) num_candidates = MAX_TREES_PER_CHUNK;
 
-  chunk->num_trees = map_range(hash2(chunk_x, chunk_z, g_world_config.seed), -1.0f, 1.0f, 0, 7);
-  chunk->trees = calloc(chunk->num_trees, sizeof(model_t));
+  // place every tree first so their ground heights come from one batched noise evaluation
+  float tree_xs[MAX_TREES_PER_CHUNK], tree_zs[MAX_TREES_PER_CHUNK], tree_heights[MAX_TREES_PER_CHUNK];
+  for (usize i = 0; i < num_candidates; ++i) {
+    tree_xs[i] = map_range(hash2(chunk_x * 100 + i, chunk_z * 100 + i * 3, g_world_config.seed), -1.0f, 1.0f, world_x + 2, world_x + g_world_config.chunk_size - 2);
+    tree_zs[i] = map_range(hash2(chunk_z * 100 + i * 7, chunk_x * 100 + i * 5, g_world_config.seed), -1.0f, 1.0f, world_z + 2, world_z + g_world_config.chunk_size - 2);
+  }
+  terrain_height_batch(tree_xs, tree_zs, num_candidates, g_world_config.seed, tree_heights);
 
-  for (usize i = 0; i < chunk->num_trees; ++i) {
-    float tree_x = map_range(hash2(chunk_x * 100 + i, chunk_z * 100 + i * 3, g_world_config.seed), -1.0f, 1.0f, world_x + 2, world_x + g_world_config.chunk_size - 2);
-    float tree_z = map_range(hash2(chunk_z * 100 + i * 7, chunk_x * 100 + i * 5, g_world_config.seed), -1.0f, 1.0f, world_z + 2, world_z + g_world_config.chunk_size - 2);
-    float tree_y = terrainHeight(tree_x, tree_z, g_world_config.seed) - 0.5f;
+  // trees on lake ice are dropped, so tree_instances only holds placed trees
+  chunk->num_trees = 0;
+  chunk->tree_instances = chunk_arena_alloc(chunk->arena, num_candidates * sizeof(tree_instance_t));
+  if (!chunk->tree_instances) num_candidates = 0;
+
+  for (usize i = 0; i < num_candidates; ++i) {
+    float tree_x = tree_xs[i];
+    float tree_z = tree_zs[i];
+    float tree_y = tree_heights[i] - 0.5f;
 
     if (tree_y <= 0.1f) {
       continue;
@@ -59,40 +70,185 @@ static void generate_chunk(chunk_t *chunk, int chunk_x, int chunk_z) {
       lod_factor = 0.7f;
       segments = 4;
     }
-    float base_radius = map_range(hash2(tree_pos.x, tree_pos.z, g_world_config.seed), -1.0f, 1.0f, 0.4f, 0.55f);
-    float base_angle = map_range(hash2(tree_pos.x, tree_pos.z, g_world_config.seed), -1.0f, 1.0f, 0.0f, 2.0f * PI);
 
-    float branch_chance = map_range(hash2(tree_pos.x, tree_pos.z, g_world_config.seed), -1.0f, 1.0f, 0.85 * lod_factor, 0.95 * lod_factor);
+    // the shape parameters pick the archetype, a second hash picks one of its variants
     usize max_branches = (usize)map_range(hash2(tree_pos.x, tree_pos.z, g_world_config.seed), -1.0f, 1.0f, 4.f * lod_factor, 6.f * lod_factor);
     usize num_levels = (usize)map_range(hash2(tree_pos.x, tree_pos.z, g_world_config.seed), -1.0f, 1.0f, 4.f * lod_factor, 5.f * lod_factor);
-    if (max_branches < 3) max_branches = 3;
-    if (num_levels < 4) num_levels = 4;
-    if (branch_chance < 0.75) branch_chance = 0.75;
+    usize variant = (usize)map_range(hash2(tree_pos.z, tree_pos.x, g_world_config.seed), -1.0f, 1.0f, 0.0f, (float)tree_library_variants());
+
+    u16 archetype = tree_archetype_id(segments, max_branches, num_levels, variant);
+    if (!tree_archetype(archetype)) continue;
 
-    chunk->trees[i].frag_shader = &tree_frag;
+    // every tree is turned and scaled on its own, so neighbours sharing an archetype still differ
+    u8 yaw = (u8)map_range(hash2(chunk_x * 100 + i * 11, chunk_z * 100 + i * 13, g_world_config.seed), -1.0f, 1.0f, 0.0f, 255.0f);
+    u8 scale = (u8)map_range(hash2(chunk_z * 100 + i * 17, chunk_x * 100 + i * 19, g_world_config.seed), -1.0f, 1.0f, 0.0f, 255.0f);
 
-    generate_tree(&(chunk->trees[i]), base_radius, base_angle, tree_pos, branch_chance, 0, max_branches, num_levels, segments);
+    chunk->tree_instances[chunk->num_trees++] = (tree_instance_t){ .position = tree_pos, .archetype = archetype, .yaw = yaw, .scale = scale };
   }
 }
 
-static usize render_chunk(renderer_t *state, chunk_t *chunk, transform_t *camera, light_t *lights, const usize num_lights, scene_t *scene) {
-  (void)scene;
-  usize triangles_rendered = 0;
-  if (chunk->ground_plane.vertex_data != NULL && chunk->ground_plane.num_vertices > 0) {
-    triangles_rendered += render_model(state, camera, &chunk->ground_plane, lights, num_lights);
+// Bounds of everything queue_chunk may record for a chunk, the ground LODs hold world space positions
+static void compute_chunk_bounds(chunk_t *chunk) {
+  float3 lo = make_float3(FLT_MAX, FLT_MAX, FLT_MAX);
+  float3 hi = make_float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+  for (int level = 0; level < g_world_config.ground_lod_levels; ++level) {
+    const model_t *ground = &chunk->ground_lods[level];
+    for (usize i = 0; i < ground->num_vertices; ++i) {
+      float3 p = ground->vertex_data[i].position;
+      lo = make_float3(fminf(lo.x, p.x), fminf(lo.y, p.y), fminf(lo.z, p.z));
+      hi = make_float3(fmaxf(hi.x, p.x), fmaxf(hi.y, p.y), fmaxf(hi.z, p.z));
+    }
   }
 
   for (usize i = 0; i < chunk->num_trees; ++i) {
-    if (chunk->trees[i].vertex_data != NULL && chunk->trees[i].num_vertices > 0) {
-      triangles_rendered += render_model(state, camera, &chunk->trees[i], lights, num_lights);
-    }
+    const tree_archetype_t *archetype = tree_archetype(chunk->tree_instances[i].archetype);
+    if (!archetype) continue;
+
+    float3 tree_min, tree_max;
+    tree_instance_bounds(&chunk->tree_instances[i], archetype, &tree_min, &tree_max);
+    lo = make_float3(fminf(lo.x, tree_min.x), fminf(lo.y, tree_min.y), fminf(lo.z, tree_min.z));
+    hi = make_float3(fmaxf(hi.x, tree_max.x), fmaxf(hi.y, tree_max.y), fmaxf(hi.z, tree_max.z));
+  }
+
+  // a chunk without geometry gets an empty box at its corner
+  if (lo.x > hi.x) {
+    lo = hi = make_float3(chunk->x * g_world_config.chunk_size, 0, chunk->z * g_world_config.chunk_size);
+  }
+
+  chunk->aabb_min = lo;
+  chunk->aabb_max = hi;
+}
+
+// Runs on chunk worker threads, must only touch its own chunk and read-only globals
+void generate_chunk(chunk_t *chunk, int chunk_x, int chunk_z) {
+  if (chunk == NULL) return;
+
+  chunk->x = chunk_x;
+  chunk->z = chunk_z;
+  for (usize i = 0; i < MAX_GROUND_LODS; ++i) chunk->ground_lods[i] = (model_t){0};
+
+  // every allocation below comes from the arena, a chunk without one stays empty
+  chunk->arena = chunk_arena_acquire();
+
+  // heights, albedo and trees come from the on-disk store when this chunk was generated before
+  bool stored = chunk_store_load(chunk, chunk_x, chunk_z);
+  if (!stored) {
+    chunk->heights = generate_heightfield(chunk->arena, chunk_x, chunk_z);
+    chunk->albedo_size = g_world_config.chunk_size * g_world_config.ground_texels_per_unit;
+    chunk->albedo = generate_ground_albedo(chunk->arena, chunk_x, chunk_z, chunk->heights, chunk->albedo_size);
+    if (!chunk->albedo) chunk->albedo_size = 0;
+    place_trees(chunk, chunk_x, chunk_z);
+  }
+
+  // the shadow mask depends on the neighbours and the sun, update_shadow_masks builds it once resident
+  chunk->shadow_mask = NULL;
+  chunk->shadow_size = 0;
+  chunk->shadow_neighbours = 0;
+
+  float corner_x = chunk_x * g_world_config.chunk_size;
+  float corner_z = chunk_z * g_world_config.chunk_size;
+
+  // ground meshes are cheap to rebuild from the heights, so they are never stored
+  for (int level = 0; level < g_world_config.ground_lod_levels; ++level) {
+    float segment_size = (float)(1 << level);
+    generate_ground_plane(&chunk->ground_lods[level], make_float2(g_world_config.chunk_size, g_world_config.chunk_size), make_float2(segment_size, segment_size), make_float3(corner_x + g_world_config.half_chunk_size, 0, corner_z + g_world_config.half_chunk_size), chunk);
+    chunk->ground_lods[level].frag_shader = &ground_shadow_frag;
+  }
+
+  if (!stored) chunk_store_save(chunk);
+
+  compute_chunk_bounds(chunk);
+  build_tree_grid(chunk);
+}
+
+// Upper bound on what generate_chunk and update_shadow_masks allocate for one chunk
+static usize chunk_arena_size(void) {
+  usize stride = (usize)g_world_config.chunk_size + 1;
+  usize albedo_size = (usize)g_world_config.chunk_size * g_world_config.ground_texels_per_unit;
+  usize shadow_size = (usize)g_world_config.chunk_size * g_world_config.tree_shadow_texels_per_unit;
+
+  usize size = stride * stride * sizeof(float);
+  size += albedo_size * albedo_size * sizeof(u32);
+  size += shadow_size * shadow_size;
+  size += MAX_TREES_PER_CHUNK * sizeof(tree_instance_t);
+
+  for (int level = 0; level < g_world_config.ground_lod_levels; ++level) {
+    usize faces = ground_plane_max_faces((usize)g_world_config.chunk_size >> level);
+    size += faces * 3 * sizeof(vertex_data_t) + faces * sizeof(float3);
   }
 
-  return triangles_rendered;
+  // alignment padding, one block per allocation
+  return size + (5 + 2 * MAX_GROUND_LODS) * 16;
+}
+
+// Ground LOD for a chunk whose center is distance units from the camera
+static int ground_lod_level(float distance) {
+  int level = (int)(distance / g_world_config.ground_lod_distance);
+  return level < g_world_config.ground_lod_levels ? level : g_world_config.ground_lod_levels - 1;
+}
+
+// What chunks and trees are tested against before drawing and the shaders they are drawn with,
+// hiz stays NULL until the occluders are drawn. With world.hiz_verify the draws the pyramid
+// rejects are recorded in occluded, otherwise it is NULL
+typedef struct {
+  frustum_t frustum;
+  screen_projection_t projection;
+  const hiz_t *hiz;
+  draw_list_t *occluded;
+  render_pass_t pass;
+  fragment_shader_t *ground_frag, *tree_frag;
+} cull_context_t;
+
+// Records the chunk's ground and its visible trees, nothing is drawn until render_draw_list
+static void queue_chunk(draw_list_t *list, chunk_t *chunk, float distance, const transform_t *camera, const cull_context_t *cull, scene_stats_t *stats) {
+  model_t *ground = &chunk->ground_lods[ground_lod_level(distance)];
+  if (ground->vertex_data != NULL && ground->num_vertices > 0) {
+    draw_item_t item = {
+      .model = ground,
+      .position = ground->transform.position,
+      .frag_shader = cull->ground_frag,
+      .pass = cull->pass
+    };
+    push_draw_item(list, &item);
+  }
+
+  float impostor_distance_sq = g_world_config.tree_impostor_distance * g_world_config.tree_impostor_distance;
+  for (usize i = 0; i < chunk->num_trees; ++i) {
+    const tree_instance_t *instance = &chunk->tree_instances[i];
+    tree_archetype_t *archetype = tree_archetype(instance->archetype);
+    if (!archetype) continue;
+
+    float3 tree_min, tree_max;
+    tree_instance_bounds(instance, archetype, &tree_min, &tree_max);
+    if (!frustum_test_aabb(&cull->frustum, tree_min, tree_max)) {
+      stats->trees_culled++;
+      continue;
+    }
+
+    float dx = instance->position.x - camera->position.x;
+    float dz = instance->position.z - camera->position.z;
+    draw_item_t item = { .position = instance->position, .tree = instance, .pass = cull->pass };
+
+    // distant trees swap their mesh for a sprite when one was baked
+    if (dx * dx + dz * dz > impostor_distance_sq && archetype->impostor.sprites) {
+      item.impostor = &archetype->impostor;
+    } else {
+      item.frag_shader = cull->tree_frag;
+    }
+
+    if (hiz_test_aabb(cull->hiz, &cull->projection, tree_min, tree_max)) {
+      stats->trees_occluded++;
+      if (cull->occluded) push_draw_item(cull->occluded, &item);
+      continue;
+    }
+    stats->trees_drawn++;
+
+    push_draw_item(list, &item);
+  }
 }
 
 void init_scene(scene_t *scene, usize max_loaded_chunks) {
-  (void)max_loaded_chunks;
   if (!scene) return;
   
   scene->controller = (fps_controller_t){
@@ -106,72 +262,227 @@ void init_scene(scene_t *scene, usize max_loaded_chunks) {
   };
   
   scene->camera_pos = (transform_t){ 0 };
+  scene->stats = (scene_stats_t){ 0 };
+  scene->hiz = (hiz_t){ 0 };
+  scene->draw_list = (draw_list_t){ 0 };
   
-  init_chunk_map(&scene->chunk_map, CHUNK_MAP_NUM_BUCKETS);
+  init_chunk_map(&scene->chunk_map, g_world_config.resident_width);
+
+  // the map holds at most max_chunks, every arena past that is held by the eviction cache or a worker
+  init_chunk_arena_pool(g_world_config.max_chunks, chunk_arena_size());
+
+  // the batch noise only replaces terrainHeight where it matches it exactly, decided before any chunk exists
+  verify_terrain_batch();
+
+  // the workers place trees from the library, so it is complete before they start
+  if (init_tree_library() != 0) printf("Failed to allocate the tree library, trees are disabled\n");
+  init_chunk_store(g_world_config.chunk_store_dir);
+  init_chunk_loader(max_loaded_chunks, g_world_config.chunk_worker_threads);
+
+  scene->residency = (chunk_residency_t){ 0 };
+  init_chunk_cache(&scene->residency.cache, (usize)g_world_config.chunk_cache_mb * 1024 * 1024);
+}
+
+static void free_render_scratch(render_scratch_t *scratch) {
+  free(scratch->chunks);
+  free(scratch->sorted_chunks);
+  free_draw_list(&scratch->occluded);
+  free(scratch->occluder_depth);
+  free(scratch->check_depth);
+  free(scratch->check_framebuffer);
+  *scratch = (render_scratch_t){ 0 };
+}
+
+// Grows the chunk lists to count entries, returns false if they could not be
+static bool reserve_chunk_scratch(render_scratch_t *scratch, usize count) {
+  if (scratch->chunk_capacity >= count) return true;
+
+  chunk_t **chunks = realloc(scratch->chunks, count * sizeof(chunk_t*));
+  if (chunks) scratch->chunks = chunks;
+  chunk_distance_t *sorted_chunks = realloc(scratch->sorted_chunks, count * sizeof(chunk_distance_t));
+  if (sorted_chunks) scratch->sorted_chunks = sorted_chunks;
+
+  if (!chunks || !sorted_chunks) return false;
+  scratch->chunk_capacity = count;
+  return true;
+}
+
+// Grows the hiz_verify buffers to a num_pixels frame, returns false if they could not be
+static bool reserve_check_scratch(render_scratch_t *scratch, usize num_pixels) {
+  if (scratch->pixel_capacity >= num_pixels) return true;
+
+  float *occluder_depth = realloc(scratch->occluder_depth, num_pixels * sizeof(float));
+  if (occluder_depth) scratch->occluder_depth = occluder_depth;
+  float *check_depth = realloc(scratch->check_depth, num_pixels * sizeof(float));
+  if (check_depth) scratch->check_depth = check_depth;
+  u32 *check_framebuffer = realloc(scratch->check_framebuffer, num_pixels * sizeof(u32));
+  if (check_framebuffer) scratch->check_framebuffer = check_framebuffer;
+
+  if (!occluder_depth || !check_depth || !check_framebuffer) return false;
+  scratch->pixel_capacity = num_pixels;
+  return true;
+}
+
+void free_scene(scene_t *scene) {
+  if (!scene) return;
+
+  // workers must be stopped before the map their results go into is freed
+  free_chunk_loader();
+  free_chunk_map(&scene->chunk_map);
+  free_chunk_cache(&scene->residency.cache);
+  free_chunk_arena_pool();
+  free_hiz(&scene->hiz);
+  free_draw_list(&scene->draw_list);
+  free_render_scratch(&scene->scratch);
+
+  // the workers are stopped above, so no load or save is still using a region file
+  free_chunk_store();
+  free_tree_library();
+}
+
+int init_scene_snapshot(scene_t *view, const scene_t *scene) {
+  if (!view || !scene) return -1;
+
+  *view = (scene_t){ 0 };
+  usize num_cells = (usize)scene->chunk_map.width * scene->chunk_map.width;
+  view->chunk_map.cells = calloc(num_cells, sizeof(chunk_map_node_t));
+  return view->chunk_map.cells ? 0 : -1;
+}
+
+void free_scene_snapshot(scene_t *view) {
+  if (!view) return;
+
+  // the chunks belong to the scene the snapshot was taken from, only the cells are the view's
+  free(view->chunk_map.cells);
+  free_hiz(&view->hiz);
+  free_draw_list(&view->draw_list);
+  free_render_scratch(&view->scratch);
+  *view = (scene_t){ 0 };
+}
+
+void snapshot_scene(scene_t *view, const scene_t *scene) {
+  if (!view || !scene || !view->chunk_map.cells) return;
+
+  // render state and counters stay with the view, the caller collects the stats
+  chunk_map_node_t *cells = view->chunk_map.cells;
+  hiz_t hiz = view->hiz;
+  draw_list_t draw_list = view->draw_list;
+  render_scratch_t scratch = view->scratch;
+  scene_stats_t stats = view->stats;
+
+  *view = *scene;
+  view->chunk_map.cells = cells;
+  memcpy(cells, scene->chunk_map.cells, (usize)scene->chunk_map.width * scene->chunk_map.width * sizeof(chunk_map_node_t));
+  view->hiz = hiz;
+  view->draw_list = draw_list;
+  view->scratch = scratch;
+  view->stats = stats;
+}
+
+// Move the anchor to the player's chunk once they are more than chunk_hysteresis past its border,
+// so walking along a border does not flip the load square back and forth every tick
+static void update_anchor(chunk_residency_t *residency, float3 position) {
+  int player_chunk_x = (int)floorf(position.x / g_world_config.chunk_size);
+  int player_chunk_z = (int)floorf(position.z / g_world_config.chunk_size);
+
+  if (!residency->anchored) {
+    residency->anchor_x = player_chunk_x;
+    residency->anchor_z = player_chunk_z;
+    residency->anchored = true;
+    return;
+  }
+
+  float margin = g_world_config.chunk_hysteresis;
+  float min_x = residency->anchor_x * g_world_config.chunk_size - margin;
+  float min_z = residency->anchor_z * g_world_config.chunk_size - margin;
+  float max_x = (residency->anchor_x + 1) * g_world_config.chunk_size + margin;
+  float max_z = (residency->anchor_z + 1) * g_world_config.chunk_size + margin;
+
+  if (position.x < min_x || position.x > max_x || position.z < min_z || position.z > max_z) {
+    residency->anchor_x = player_chunk_x;
+    residency->anchor_z = player_chunk_z;
+  }
 }
 
-bool cull_chunk(chunk_t *chunk, void *param, usize num_params) {
+static inline int anchor_distance(const chunk_residency_t *residency, int chunk_x, int chunk_z) {
+  int dx = abs(chunk_x - residency->anchor_x);
+  int dz = abs(chunk_z - residency->anchor_z);
+  return dx > dz ? dx : dz;
+}
+
+// true for chunks outside the load square (wanted set)
+static bool outside_load_radius(chunk_t *chunk, void *param, usize num_params) {
   (void)num_params;
   if (!chunk || !param) return true;
-  
-  transform_t *player = (transform_t*)param;
-  
-  // Calculate player's chunk coordinates (handle negative coordinates properly)
-  int player_chunk_x = (int)floorf(player->position.x / g_world_config.chunk_size);
-  int player_chunk_z = (int)floorf(player->position.z / g_world_config.chunk_size);
-  
-  // Check if chunk is within the 2x3 grid pattern
-  int dx = chunk->x - player_chunk_x;
-  int dz = chunk->z - player_chunk_z;
-  
-  float3 right, up, fwd;
-  transform_get_inverse_basis_vectors(player, &right, &up, &fwd);
-  
-  // Check if chunk matches the xxx/xPx pattern
-  float chunk_offsets[][2] = {
-    {0, 0}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}
-  };
-  
-  int num_chunks = sizeof(chunk_offsets) / sizeof(chunk_offsets[0]);
-  
-  for (int i = 0; i < num_chunks; i++) {
-    float rel_x = chunk_offsets[i][0];
-    float rel_z = chunk_offsets[i][1];
-    int world_dx = (int)roundf(rel_x * right.x + rel_z * fwd.x);
-    int world_dz = (int)roundf(rel_x * right.z + rel_z * fwd.z);
-    
-    if (dx == world_dx && dz == world_dz) {
-      return false; // chunk is within the pattern
-    }
-  }
-  
-  return true; // cull chunk outside the 2x3 grid
+
+  return anchor_distance((chunk_residency_t*)param, chunk->x, chunk->z) > g_world_config.chunk_load_radius;
+}
+
+// true for chunks outside the load square plus the hysteresis ring (resident set)
+static bool outside_resident_radius(chunk_t *chunk, void *param, usize num_params) {
+  (void)num_params;
+  if (!chunk || !param) return true;
+
+  return anchor_distance((chunk_residency_t*)param, chunk->x, chunk->z) > g_world_config.chunk_load_radius + 1;
 }
 
 void update_loaded_chunks(scene_t *scene) {
-  remove_chunk_if(&scene->chunk_map, cull_chunk, &scene->camera_pos, 1);
+  profiler_begin(PROFILE_CHUNK_UPDATE);
+
+  chunk_residency_t *residency = &scene->residency;
 
-  int player_chunk_x = (int)floorf(scene->camera_pos.position.x / g_world_config.chunk_size);
-  int player_chunk_z = (int)floorf(scene->camera_pos.position.z / g_world_config.chunk_size);
+  // chunks finished by the workers since the last tick become resident now
+  chunk_loader_publish(&scene->chunk_map, &scene->stats);
+
+  update_anchor(residency, scene->camera_pos.position);
+
+  // evicted chunks go to the cache rather than being freed
+  chunk_t evicted[16];
+  usize num_evicted;
+  do {
+    num_evicted = take_chunks_if(&scene->chunk_map, outside_resident_radius, residency, 1, evicted, 16);
+    for (usize i = 0; i < num_evicted; ++i) {
+      chunk_cache_put(&residency->cache, &evicted[i]);
+    }
+  } while (num_evicted == 16);
+
+  chunk_loader_cancel_if(outside_load_radius, residency, 1);
 
   for (int dx = -g_world_config.chunk_load_radius; dx <= g_world_config.chunk_load_radius; dx++) {
     for (int dz = -g_world_config.chunk_load_radius; dz <= g_world_config.chunk_load_radius; dz++) {
-      int chunk_x = player_chunk_x + dx;
-      int chunk_z = player_chunk_z + dz;
+      int chunk_x = residency->anchor_x + dx;
+      int chunk_z = residency->anchor_z + dz;
 
-      if (!is_chunk_loaded(&scene->chunk_map, chunk_x, chunk_z)) {
-        chunk_t new_chunk = {0};
-        generate_chunk(&new_chunk, chunk_x, chunk_z);
-        insert_chunk(&scene->chunk_map, &new_chunk);
+      if (is_chunk_loaded(&scene->chunk_map, chunk_x, chunk_z)) continue;
+
+      chunk_t cached;
+      if (chunk_cache_take(&residency->cache, chunk_x, chunk_z, &cached)) {
+        insert_chunk(&scene->chunk_map, &cached);
+        scene->stats.chunks_reused++;
+        continue;
       }
+
+      // nearest chunks are generated first, re-requesting refreshes the priority as the player moves
+      float center_x = chunk_x * g_world_config.chunk_size + g_world_config.half_chunk_size;
+      float center_z = chunk_z * g_world_config.chunk_size + g_world_config.half_chunk_size;
+      float distance = float2_magnitude(make_float2(center_x - scene->camera_pos.position.x, center_z - scene->camera_pos.position.z));
+
+      chunk_loader_request(chunk_x, chunk_z, distance);
     }
   }
+
+  profiler_end(PROFILE_CHUNK_UPDATE);
+}
+
+// Waits for the chunks update_loaded_chunks requested and makes them resident right away, so the
+// chunks that exist after a tick are the same on every run. The benchmark calls it after each tick
+void finish_chunk_loads(scene_t *scene) {
+  profiler_begin(PROFILE_CHUNK_UPDATE);
+  chunk_loader_wait_idle();
+  chunk_loader_publish(&scene->chunk_map, &scene->stats);
+  profiler_end(PROFILE_CHUNK_UPDATE);
 }
 
-typedef struct {
-  chunk_t *chunk;
-  float distance;
-} chunk_distance_t;
 static int compare_chunks_by_distance(const void *a, const void *b) {
   const chunk_distance_t *chunk_a = (const chunk_distance_t*)a;
   const chunk_distance_t *chunk_b = (const chunk_distance_t*)b;
@@ -181,24 +492,40 @@ static int compare_chunks_by_distance(const void *a, const void *b) {
   return 0;
 }
 
-usize render_loaded_chunks(renderer_t *state, scene_t *scene, light_t *lights, const usize num_lights) {
-  set_shadow_scene(scene);
+// Redraws every draw the pyramid rejected, one at a time, over a copy of the depth the pyramid was
+// built from. A correct rejection leaves that depth as it was, a draw that changes it was visible.
+// The draws go to the scratch buffers, the frame is not touched
+static void check_occluded_draws(const renderer_t *state, scene_t *scene, light_t *lights, usize num_lights) {
+  render_scratch_t *scratch = &scene->scratch;
+  usize num_pixels = (usize)state->width * state->height;
+  renderer_t check = *state;
+  check.framebuffer = scratch->check_framebuffer;
+  check.depth_buffer = scratch->check_depth;
+
+  for (usize i = 0; i < scratch->occluded.count; ++i) {
+    memcpy(check.depth_buffer, scratch->occluder_depth, num_pixels * sizeof(float));
+    render_draw_item(&check, &scene->camera_pos, &scratch->occluded, i, lights, num_lights);
+
+    scene->stats.hiz_checked++;
+    if (memcmp(check.depth_buffer, scratch->occluder_depth, num_pixels * sizeof(float)) != 0) scene->stats.hiz_misses++;
+  }
+}
+
+usize render_loaded_chunks(renderer_t *state, scene_t *scene, light_t *lights, const usize num_lights, render_pass_t pass) {
+  render_scratch_t *scratch = &scene->scratch;
+  if (!reserve_chunk_scratch(scratch, (usize)g_world_config.max_chunks)) return 0;
 
-  chunk_t **chunks = calloc(g_world_config.max_chunks, sizeof(chunk_t*));
+  chunk_t **chunks = scratch->chunks;
+  chunk_distance_t *sorted_chunks = scratch->sorted_chunks;
   usize chunk_count = 0;
   usize total_triangles_rendered = 0;
 
   get_all_chunks(&scene->chunk_map, chunks, &chunk_count);
-
-  if (chunk_count == 0) {
-    free(chunks);
-    return 0;
-  }
-
-  chunk_distance_t *sorted_chunks = calloc(chunk_count, sizeof(chunk_distance_t));
+  if (chunk_count == 0) return 0;
 
   float2 camera_pos = make_float2(scene->camera_pos.position.x, scene->camera_pos.position.z);
   for (usize i = 0; i < chunk_count; i++) {
+    sorted_chunks[i] = (chunk_distance_t){ 0 };
     if (chunks[i]) {
       float2 chunk_center = make_float2(
         chunks[i]->x * g_world_config.chunk_size + g_world_config.half_chunk_size,
@@ -212,39 +539,77 @@ usize render_loaded_chunks(renderer_t *state, scene_t *scene, light_t *lights, c
     }
   }
 
-  // Get camera forward vector (player looks in -Z direction)
-  float3 right, up, forward;
-  transform_get_basis_vectors(&scene->camera_pos, &right, &up, &forward);
+  // the volume the renderer projects, whole chunks and then single trees are tested against it
+  fragment_shader_t ground_frag = pass == RENDER_PASS_VISIBILITY ? ground_visibility_frag : ground_shadow_shader(scene);
+  fragment_shader_t tree_shader = pass == RENDER_PASS_VISIBILITY ? tree_visibility_frag : tree_frag;
+  cull_context_t cull = { .hiz = NULL, .pass = pass, .ground_frag = &ground_frag, .tree_frag = &tree_shader };
+  init_screen_projection(&cull.projection, state, &scene->camera_pos);
+  init_frustum(&cull.frustum, &cull.projection, state);
+
+  // the pyramid follows the renderer's resolution, occlusion culling is skipped if it cannot be allocated
+  bool use_hiz = g_world_config.hiz_occluder_chunks > 0;
+  if (use_hiz && (scene->hiz.width != (int)state->width || scene->hiz.height != (int)state->height)) {
+    free_hiz(&scene->hiz);
+    use_hiz = init_hiz(&scene->hiz, (int)state->width, (int)state->height) == 0;
+  }
+
+  // with world.hiz_verify the depth the pyramid is built from is kept and every rejected draw is
+  // checked against it once the frame is drawn
+  usize num_pixels = (usize)state->width * state->height;
+  if (use_hiz && g_world_config.hiz_verify && reserve_check_scratch(scratch, num_pixels)) {
+    scratch->occluded.count = 0;
+    cull.occluded = &scratch->occluded;
+  }
 
   qsort(sorted_chunks, chunk_count, sizeof(chunk_distance_t), compare_chunks_by_distance);
+  draw_list_t *list = &scene->draw_list;
+  list->count = 0;
+  usize num_drawn = 0;
   for (usize i = 0; i < chunk_count; i++) {
-    if (sorted_chunks[i].chunk) {
-      // Calculate vector from camera to chunk center
-      float3 chunk_center = make_float3(
-        sorted_chunks[i].chunk->x * g_world_config.chunk_size + g_world_config.half_chunk_size,
-        0,
-        sorted_chunks[i].chunk->z * g_world_config.chunk_size + g_world_config.half_chunk_size
-      );
-      float3 to_chunk = float3_sub(chunk_center, scene->camera_pos.position);
+    chunk_t *chunk = sorted_chunks[i].chunk;
 
-      // Check if we're in overhead mode (pitch near -PI/2)
-      bool is_overhead = fabsf(scene->camera_pos.pitch + PI / 2) < 0.1f;
+    // resident chunks in the hysteresis ring are kept for reuse but not drawn
+    if (!chunk || outside_load_radius(chunk, &scene->residency, 1)) continue;
 
-      // Dot product with forward vector (negative because forward is -Z)
-      // If dot < 0, chunk is behind the camera (except in overhead mode)
-      // Add chunk_size buffer to account for chunk size and avoid culling visible chunks
-      float dot = is_overhead ? 1.0f : float3_dot(to_chunk, forward);
-      if (dot < -(g_world_config.chunk_size * 2)) {
-        // Chunk is fully behind the player, skip rendering
-        continue;
+    if (!frustum_test_aabb(&cull.frustum, chunk->aabb_min, chunk->aabb_max)) {
+      scene->stats.chunks_culled++;
+      continue;
+    }
+    if (hiz_test_aabb(cull.hiz, &cull.projection, chunk->aabb_min, chunk->aabb_max)) {
+      scene->stats.chunks_occluded++;
+
+      // checked as its ground and trees would have been drawn, without counting them
+      if (cull.occluded) {
+        cull_context_t unoccluded = cull;
+        unoccluded.hiz = NULL;
+        scene_stats_t uncounted = { 0 };
+        queue_chunk(cull.occluded, chunk, sorted_chunks[i].distance, &scene->camera_pos, &unoccluded, &uncounted);
       }
+      continue;
+    }
+    scene->stats.chunks_drawn++;
 
-      total_triangles_rendered += render_chunk(state, sorted_chunks[i].chunk, &scene->camera_pos, lights, num_lights, scene);
+    queue_chunk(list, chunk, sorted_chunks[i].distance, &scene->camera_pos, &cull, &scene->stats);
+
+    // chunks are drawn front to back, once the nearest are in the depth buffer they occlude the rest
+    if (use_hiz && ++num_drawn == (usize)g_world_config.hiz_occluder_chunks) {
+      total_triangles_rendered += render_draw_list(state, &scene->camera_pos, list, lights, num_lights);
+      list->count = 0;
+
+      profiler_begin(PROFILE_HIZ_BUILD);
+      build_hiz(&scene->hiz, state->depth_buffer);
+      profiler_end(PROFILE_HIZ_BUILD);
+      cull.hiz = &scene->hiz;
+      if (cull.occluded) memcpy(scratch->occluder_depth, state->depth_buffer, num_pixels * sizeof(float));
     }
   }
 
-  free(chunks);
-  free(sorted_chunks);
+  total_triangles_rendered += render_draw_list(state, &scene->camera_pos, list, lights, num_lights);
+  list->count = 0;
+
+  if (cull.occluded && cull.hiz) {
+    check_occluded_draws(state, scene, lights, num_lights);
+  }
 
   return total_triangles_rendered;
 }
\ No newline at end of file
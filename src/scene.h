@@ -5,8 +5,10 @@
 #include <shader-works/primitives.h>
 #include <shader-works/maths.h>
 
+#include "util/chunk_cache.h"
 #include "util/chunk_map.h"
 #include "util/config.h"
+#include "util/hiz.h"
 
 typedef struct {
   float move_speed;
@@ -18,12 +20,84 @@ typedef struct {
   uint64_t last_frame_time;
 } fps_controller_t;
 
+// Forward shades every fragment as it is rasterized, visibility only records which surface covers
+// each pixel so resolve_visibility_buffer can shade it once afterwards
+typedef enum {
+  RENDER_PASS_FORWARD,
+  RENDER_PASS_VISIBILITY
+} render_pass_t;
+
+// One render_model call of render_loaded_chunks, recorded so the nearest chunks can be drawn as
+// occluders before the rest are tested against the Hi-Z pyramid
+typedef struct {
+  model_t *model;                   // ground LOD drawn through a copy, NULL for trees
+  tree_impostor_t *impostor;        // set for trees drawn as sprites, the rest draw their archetype's mesh
+  float3 position;                  // where the copy or the sprite is placed
+  const tree_instance_t *tree;      // turn and scale of tree draws, NULL for ground
+  fragment_shader_t *frag_shader;   // shader of the copy, impostors pick theirs from pass
+  render_pass_t pass;
+} draw_item_t;
+
+typedef struct {
+  draw_item_t *items;
+  usize count, capacity;
+} draw_list_t;
+
+typedef struct {
+  chunk_t *chunk;
+  float distance;
+} chunk_distance_t;
+
+// Storage render_loaded_chunks needs every frame, grown to the largest frame and kept with the
+// scene so nothing is allocated per frame
+typedef struct {
+  chunk_t **chunks;
+  chunk_distance_t *sorted_chunks;
+  usize chunk_capacity;
+
+  // with world.hiz_verify, the draws the pyramid rejected, the depth it was built from and the
+  // private buffers the rejected draws are redrawn into
+  draw_list_t occluded;
+  float *occluder_depth, *check_depth;
+  u32 *check_framebuffer;
+  usize pixel_capacity;
+} render_scratch_t;
+
+// Counters accumulated by update_loaded_chunks and render_loaded_chunks, cleared by whoever reports them
+typedef struct {
+  usize chunks_generated;
+  usize chunks_reused;      // served from the eviction cache instead of being regenerated
+  uint64_t chunk_gen_time;  // SDL performance counter ticks spent in generate_chunk
+
+  usize chunks_drawn, chunks_culled;  // chunks inside the load square, summed over rendered frames
+  usize trees_drawn, trees_culled;    // trees of the drawn chunks, summed over rendered frames
+  usize chunks_occluded, trees_occluded;  // inside the frustum but behind the Hi-Z pyramid
+  usize hiz_checked, hiz_misses;  // with world.hiz_verify, occluded draws redrawn and those that were not hidden
+  uint64_t fragments_shaded, pixels_covered;  // material shader runs and covered pixels, their ratio is the overdraw
+} scene_stats_t;
+
+// Wanted chunks are the load square around the anchor, resident chunks are kept until they
+// leave that square plus one ring, visible chunks are the resident ones inside the load square
+// that also pass the frustum test in render_loaded_chunks
+typedef struct {
+  int anchor_x, anchor_z;   // chunk the load square is centered on, lags the player by chunk_hysteresis
+  bool anchored;
+  chunk_cache_t cache;      // recently evicted chunks, reused when the player turns back
+} chunk_residency_t;
+
 typedef struct scene_t {
   transform_t camera_pos;
   fps_controller_t controller;
 
   chunk_map_t chunk_map;
+  chunk_residency_t residency;
   light_t sun;
+
+  hiz_t hiz;    // built by render_loaded_chunks from the nearest chunks' depth, sized to the renderer
+  draw_list_t draw_list;  // draws recorded by render_loaded_chunks, kept to reuse its storage
+  render_scratch_t scratch;
+
+  scene_stats_t stats;
 } scene_t;
 
 // Implementation found in proc_gen.c
@@ -33,18 +107,84 @@ extern float lerp(float a, float b, float t);
 extern float hash2(int x, int y, int seed);
 
 extern float noise2D(float x, float y, int seed);
+extern float fbm(float x, float y, int octaves, int seed);
 extern float ridgeNoise(float x, float y, int seed);
 extern float terrainHeight(float x, float y, int seed);
 extern float get_interpolated_terrain_height(float x, float z);
+extern float get_terrain_height(chunk_map_t *map, float x, float z);
+
+// Implementation found in noise_batch.c
+void terrain_height_batch(const float *xs, const float *zs, usize count, int seed, float *out);
+void terrain_height_grid(float x0, float z0, float step, int nx, int nz, int seed, float *out);
+bool verify_terrain_batch(void);
+float terrain_batch_max_error(void);
 
 // Implementation found in scene.c
 void init_scene(scene_t *scene, usize max_loaded_chunks);
+void free_scene(scene_t *scene);
 void update_loaded_chunks(scene_t *scene);
-usize render_loaded_chunks(renderer_t *state, scene_t *scene, light_t *lights, const usize num_lights);
+void finish_chunk_loads(scene_t *scene);
+
+// A snapshot is a copy of what rendering reads from a scene, so a render thread can draw it while
+// the next tick updates the scene. Its chunks share the scene's arenas, which must not be reused
+// while it is drawn (see chunk_arena_pool_defer_reuse). Returns 0 on success, -1 on failure
+int init_scene_snapshot(scene_t *view, const scene_t *scene);
+void free_scene_snapshot(scene_t *view);
+void snapshot_scene(scene_t *view, const scene_t *scene);
+usize render_loaded_chunks(renderer_t *state, scene_t *scene, light_t *lights, const usize num_lights, render_pass_t pass);
+
+// Implementation found in draw_list.c
+bool push_draw_item(draw_list_t *list, const draw_item_t *item);
+void free_draw_list(draw_list_t *list);
+usize render_draw_list(renderer_t *state, transform_t *camera, draw_list_t *list, light_t *lights, usize num_lights);
+usize render_draw_item(renderer_t *state, transform_t *camera, draw_list_t *list, usize index, light_t *lights, usize num_lights);
+
+// Implementation found in chunk_loader.c
+void init_chunk_loader(usize max_pending, usize num_workers);
+void free_chunk_loader(void);
+bool chunk_loader_request(int x, int z, float priority);
+bool chunk_loader_is_pending(int x, int z);
+void chunk_loader_cancel_if(query_func func, void *param, usize num_params);
+void chunk_loader_wait_idle(void);
+usize chunk_loader_publish(chunk_map_t *map, scene_stats_t *stats);
+
+// Implementation found in impostor.c
+int generate_tree_impostor(tree_impostor_t *impostor, const model_t *tree, float3 base, float3 aabb_min, float3 aabb_max);
+void free_tree_impostor(tree_impostor_t *impostor);
+usize tree_impostor_memory_size(const tree_impostor_t *impostor);
+usize render_tree_impostor(renderer_t *state, transform_t *camera, tree_impostor_t *impostor, const tree_instance_t *instance, light_t *lights, usize num_lights, render_pass_t pass);
+u32 shade_impostor_texel(u32 texel, fragment_context_t *ctx);
+
+// Implementation found in tree_library.c
+int init_tree_library(void);
+void free_tree_library(void);
+u16 tree_archetype_id(usize segments, usize max_branches, usize num_levels, usize variant);
+tree_archetype_t *tree_archetype(u16 id);
+void tree_instance_bounds(const tree_instance_t *instance, const tree_archetype_t *archetype, float3 *out_min, float3 *out_max);
+usize tree_library_variants(void);
+usize tree_library_max_vertices(void);
+usize tree_library_memory_size(void);
+
+// Implementation found in shadows.c
+void update_shadow_masks(scene_t *scene);
+bool chunk_in_tree_shadow(const chunk_t *chunk, float x, float z);
 
 // Implementation found in shaders.c
-void update_quads(float3 player_pos, transform_t *camera_transform);
-usize render_quads(renderer_t *renderer, transform_t *camera, light_t *lights, usize num_lights);
+void update_quads(float3 player_pos, transform_t *camera_transform, chunk_map_t *chunk_map);
+void snapshot_quads(void);
+usize render_quads(renderer_t *renderer, transform_t *camera, render_pass_t pass);
+void free_quads(void);
+u32 ground_material(float x, float z, float terrain_height);
+fragment_shader_t ground_shadow_shader(scene_t *scene);
+void count_shaded_fragment(void);
+void count_shaded_fragments(usize count);
+usize take_shaded_fragments(void);
+
+// Implementation found in deferred.c
+u32 snow_visibility_id(void);
+u32 impostor_visibility_id(u32 texel, const fragment_context_t *ctx);
+usize resolve_visibility_buffer(renderer_t *state, scene_t *scene, light_t *lights, usize num_lights);
+usize count_covered_pixels(const renderer_t *state);
 
 
 #endif // SCENE_H
\ No newline at end of file
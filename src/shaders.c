@@ -1,22 +1,40 @@
 #include <shader-works/shaders.h>
 
-#include <SDL3/SDL.h>
 #include <math.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "scene.h"
 
 #include "util/chunk_map.h"
+#include "util/color.h"
+#include "util/point_sprites.h"
+#include "util/snow_ground.h"
 
+// The layout is checked against SDL once at startup, see check_color_format
 u32 rgb_to_u32(u8 r, u8 g, u8 b) {
-  const SDL_PixelFormatDetails *format = SDL_GetPixelFormatDetails(SDL_PIXELFORMAT_RGBA8888);
-  return SDL_MapRGBA(format, NULL, r, g, b, 255);
+  return color_pack(r, g, b);
 }
 
 void u32_to_rgb(u32 color, u8 *r, u8 *g, u8 *b) {
-  const SDL_PixelFormatDetails *format = SDL_GetPixelFormatDetails(SDL_PIXELFORMAT_RGBA8888);
-  SDL_GetRGB(color, format, NULL, r, g, b);
+  color_unpack(color, r, g, b);
+}
+
+// Material shader invocations, the shading cost behind the overdraw stat
+static atomic_size_t fragments_shaded = 0;
+
+void count_shaded_fragment(void) {
+  atomic_fetch_add_explicit(&fragments_shaded, 1, memory_order_relaxed);
+}
+
+void count_shaded_fragments(usize count) {
+  atomic_fetch_add_explicit(&fragments_shaded, count, memory_order_relaxed);
+}
+
+usize take_shaded_fragments(void) {
+  return atomic_exchange_explicit(&fragments_shaded, 0, memory_order_relaxed);
 }
 
 static float rand_float(void) {
@@ -25,7 +43,8 @@ static float rand_float(void) {
 
 u32 tree_frag_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
   (void)input; (void)args; (void)argc;
-  
+  count_shaded_fragment();
+
   // white/black noise pattern based on world position
   float check_size = 0.02f;
   float x = floorf(ctx->world_pos.x / check_size);
@@ -33,65 +52,19 @@ u32 tree_frag_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
 
   float intensity = map_range(noise2D(x, z, g_world_config.seed), -1.0f, 1.0f, 0.55f, 1.0f);
 
-  u8 r = (u8)(110.f * intensity);
-  u8 g = (u8)(90.f * intensity);
-  u8 b = (u8)(40.f * intensity);
-  return default_lighting_frag_shader.func(rgb_to_u32(r, g, b), ctx, args, argc);
+  const u32 bark = color_pack(110, 90, 40);
+  return default_lighting_frag_shader.func(color_scale(bark, color_factor(intensity)), ctx, args, argc);
 }
 
-// Check if a point is in shadow from any tree
-static bool point_in_tree_shadow(float3 world_pos, scene_t *scene) {
-  if (!scene) return false;
-
-  // Check current and neighboring chunks for tree shadows
-  for (int dx = -1; dx <= 1; dx++) {
-    for (int dz = -1; dz <= 1; dz++) {
-      int chunk_x = (int)floorf(world_pos.x / g_world_config.chunk_size) + dx;
-      int chunk_z = (int)floorf(world_pos.z / g_world_config.chunk_size) + dz;
-
-      chunk_map_node_t *node = chunk_lookup((chunk_map_t*)&scene->chunk_map, chunk_x, chunk_z);
-      if (!node || !node->loaded) continue;
-
-      chunk_t *chunk = &node->chunk;
-
-      // Check all trees in this chunk
-      for (usize i = 0; i < chunk->num_trees; i++) {
-        if (chunk->trees[i].num_vertices == 0) continue;
-
-        // Recalculate tree position using same method as generation
-        float world_x = chunk_x * g_world_config.chunk_size;
-        float world_z = chunk_z * g_world_config.chunk_size;
-        float tree_x = map_range(hash2(chunk_x * 100 + i, chunk_z * 100 + i * 3, g_world_config.seed), -1.0f, 1.0f, world_x + 2, world_x + g_world_config.chunk_size - 2);
-        float tree_z = map_range(hash2(chunk_z * 100 + i * 7, chunk_x * 100 + i * 5, g_world_config.seed), -1.0f, 1.0f, world_z + 2, world_z + g_world_config.chunk_size - 2);
-
-        // Simple circular shadow check
-        float tree_dx = world_pos.x - tree_x;
-        float tree_dz = world_pos.z - tree_z;
-        float dist_sq = tree_dx * tree_dx + tree_dz * tree_dz;
-
-        if (dist_sq < 3.24f) { // 1.8 * 1.8 = 3.24
-          return true;
-        }
-      }
-    }
-  }
-
-  return false;
-}
-
-// Shadow-enabled ground shader
-u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
-  (void)input;
-
-  // Get the actual terrain height at this world position
-  float terrain_height = get_interpolated_terrain_height(ctx->world_pos.x, ctx->world_pos.z);
-
+// Unlit ground material at a world position: ice on frozen lakes, gravel along the shore and snow above.
+// Baked per chunk by generate_ground_albedo, evaluated directly only where no bake exists
+u32 ground_material(float x, float z, float terrain_height) {
   u32 base_color;
 
   // Frozen lake ice texture
   if (terrain_height <= 0.01f) {
     // Ice surface variation
-    float ice_variation = ridgeNoise(ctx->world_pos.x * 0.1f, ctx->world_pos.z * 0.1f, g_world_config.seed + 100);
+    float ice_variation = ridgeNoise(x * 0.1f, z * 0.1f, g_world_config.seed + 100);
     ice_variation = map_range(ice_variation, 0.0f, 1.0f, 0.4f, 1.6f);
 
     // Crack detection using gradient edge detection
@@ -99,15 +72,15 @@ u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize arg
     float crack_sample_offset = 0.1f;
 
     // Primary crack layer
-    float crack1 = ridgeNoise(ctx->world_pos.x * crack_freq, ctx->world_pos.z * crack_freq, g_world_config.seed + 200);
-    float crack1_x = ridgeNoise((ctx->world_pos.x + crack_sample_offset) * crack_freq, ctx->world_pos.z * crack_freq, g_world_config.seed + 200);
-    float crack1_z = ridgeNoise(ctx->world_pos.x * crack_freq, (ctx->world_pos.z + crack_sample_offset) * crack_freq, g_world_config.seed + 200);
+    float crack1 = ridgeNoise(x * crack_freq, z * crack_freq, g_world_config.seed + 200);
+    float crack1_x = ridgeNoise((x + crack_sample_offset) * crack_freq, z * crack_freq, g_world_config.seed + 200);
+    float crack1_z = ridgeNoise(x * crack_freq, (z + crack_sample_offset) * crack_freq, g_world_config.seed + 200);
 
     // Secondary crack layer
     float crack2_freq = crack_freq * 0.7f;
-    float crack2 = ridgeNoise(ctx->world_pos.x * crack2_freq, ctx->world_pos.z * crack2_freq, g_world_config.seed + 300);
-    float crack2_x = ridgeNoise((ctx->world_pos.x + crack_sample_offset) * crack2_freq, ctx->world_pos.z * crack2_freq, g_world_config.seed + 300);
-    float crack2_z = ridgeNoise(ctx->world_pos.x * crack2_freq, (ctx->world_pos.z + crack_sample_offset) * crack2_freq, g_world_config.seed + 300);
+    float crack2 = ridgeNoise(x * crack2_freq, z * crack2_freq, g_world_config.seed + 300);
+    float crack2_x = ridgeNoise((x + crack_sample_offset) * crack2_freq, z * crack2_freq, g_world_config.seed + 300);
+    float crack2_z = ridgeNoise(x * crack2_freq, (z + crack_sample_offset) * crack2_freq, g_world_config.seed + 300);
 
     // Calculate crack edges from gradients
     float edge1 = fabsf(crack1_x - crack1) + fabsf(crack1_z - crack1);
@@ -128,8 +101,8 @@ u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize arg
   // Shore gravel texture
   else if (terrain_height <= 0.3f) {
     // Pixelated gravel coordinates
-    float gravel_x = floorf(ctx->world_pos.x / 0.15f);
-    float gravel_z = floorf(ctx->world_pos.z / 0.15f);
+    float gravel_x = floorf(x / 0.15f);
+    float gravel_z = floorf(z / 0.15f);
 
     // Gravel base color and texture
     float gravel_base = noise2D(gravel_x, gravel_z, g_world_config.seed + 500);
@@ -156,10 +129,10 @@ u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize arg
   else {
     // Generate normal ground color for higher terrain
     float check_size = 0.05f;
-    float x = floorf(ctx->world_pos.x / check_size);
-    float z = floorf(ctx->world_pos.z / check_size);
+    float check_x = floorf(x / check_size);
+    float check_z = floorf(z / check_size);
 
-    float intensity = map_range(noise2D(x, z, g_world_config.seed), -1.0f, 1.0f, 0.85f, 1.0f);
+    float intensity = map_range(noise2D(check_x, check_z, g_world_config.seed), -1.0f, 1.0f, 0.85f, 1.0f);
 
     u8 r = (u8)(255.f * intensity);
     u8 g = (u8)(255.f * intensity);
@@ -167,41 +140,77 @@ u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize arg
     base_color = rgb_to_u32(r, g, b);
   }
 
-  u32 lit_color = default_lighting_frag_shader.func(base_color, ctx, NULL, 0);
+  return base_color;
+}
+
+// Loaded chunk covering (x, z), or NULL
+static const chunk_t *chunk_at(chunk_map_t *map, float x, float z) {
+  int chunk_x = (int)floorf(x / g_world_config.chunk_size);
+  int chunk_z = (int)floorf(z / g_world_config.chunk_size);
+
+  chunk_map_node_t *node = chunk_lookup(map, chunk_x, chunk_z);
+  return (node && node->loaded) ? &node->chunk : NULL;
+}
+
+// Nearest texel of the chunk's baked ground material
+static u32 sample_ground_albedo(const chunk_t *chunk, float x, float z) {
+  float texels_per_unit = (float)chunk->albedo_size / (float)g_world_config.chunk_size;
+  int tx = (int)((x - (float)(chunk->x * g_world_config.chunk_size)) * texels_per_unit);
+  int tz = (int)((z - (float)(chunk->z * g_world_config.chunk_size)) * texels_per_unit);
+
+  if (tx < 0) tx = 0;
+  if (tz < 0) tz = 0;
+  if (tx >= chunk->albedo_size) tx = chunk->albedo_size - 1;
+  if (tz >= chunk->albedo_size) tz = chunk->albedo_size - 1;
+
+  return chunk->albedo[tz * chunk->albedo_size + tx];
+}
+
+// Shadow-enabled ground shader
+u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input;
+  count_shaded_fragment();
 
-  // Apply tree shadows if scene data is available
-  if (args && argc > 0) {
-    scene_t *scene = (scene_t*)args;
+  scene_t *scene = (args && argc > 0) ? (scene_t*)args : NULL;
+  const chunk_t *chunk = scene ? chunk_at(&scene->chunk_map, ctx->world_pos.x, ctx->world_pos.z) : NULL;
+  u32 base_color;
 
-    if (point_in_tree_shadow(ctx->world_pos, scene)) {
+  // The material is baked per chunk, only chunks without a bake evaluate the noise here
+  if (chunk && chunk->albedo) {
+    base_color = sample_ground_albedo(chunk, ctx->world_pos.x, ctx->world_pos.z);
+  } else {
+    float terrain_height = scene ? get_terrain_height(&scene->chunk_map, ctx->world_pos.x, ctx->world_pos.z)
+                                 : get_interpolated_terrain_height(ctx->world_pos.x, ctx->world_pos.z);
+    base_color = ground_material(ctx->world_pos.x, ctx->world_pos.z, terrain_height);
+  }
+
+  u32 lit_color = default_lighting_frag_shader.func(base_color, ctx, NULL, 0);
+
+  // Apply tree shadows from the chunk's baked shadow mask
+  if (chunk) {
+    if (chunk_in_tree_shadow(chunk, ctx->world_pos.x, ctx->world_pos.z)) {
       // Darken the pixel by 50%
-      u8 shadow_r, shadow_g, shadow_b;
-      u32_to_rgb(lit_color, &shadow_r, &shadow_g, &shadow_b);
-      shadow_r = (u8)(shadow_r * 0.5f);
-      shadow_g = (u8)(shadow_g * 0.5f);
-      shadow_b = (u8)(shadow_b * 0.5f);
-      return rgb_to_u32(shadow_r, shadow_g, shadow_b);
+      return color_scale(lit_color, COLOR_ONE / 2);
     }
   }
 
   return lit_color;
 }
 
-// Global scene pointer for shadow calculations
-static scene_t *g_scene_for_shadows = NULL;
-
-
 // White fragment shader for quads
 u32 white_frag_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
   (void)input; (void)ctx; (void)args; (void)argc;
-  return rgb_to_u32(255, 255, 255);
+  count_shaded_fragment();
+  return color_pack(255, 255, 255);
 }
 
-// Billboard vertex shader for camera-facing quads
+// Billboard vertex shader for camera-facing quads, argv may point to a float the quad is scaled by
+// (impostors pass their instance's scale, particles leave it NULL)
 float3 billboard_vertex_shader(vertex_context_t *context, void *argv, usize argc) {
-  (void)argv; (void)argc;
+  (void)argc;
 
-  float3 vertex = context->original_vertex;
+  float scale = argv ? *(const float *)argv : 1.0f;
+  float3 vertex = float3_scale(context->original_vertex, scale);
   float3 cam_right = context->cam_right;
   float3 cam_up = context->cam_up;
 
@@ -220,16 +229,16 @@ fragment_shader_t tree_frag = { .func = tree_frag_func, .argv = NULL, .argc = 0,
 fragment_shader_t white_frag = { .func = white_frag_func, .argv = NULL, .argc = 0, .valid = true};
 vertex_shader_t billboard_vs = { .func = billboard_vertex_shader, .argv = NULL, .argc = 0, .valid = true};
 
-// Function to set the scene data for shadow calculations
-void set_shadow_scene(scene_t *scene) {
-  g_scene_for_shadows = scene;
-  // Update the shader arguments to point to the scene
-  ground_shadow_frag.argv = g_scene_for_shadows;
-  ground_shadow_frag.argc = sizeof(scene_t);
+// Ground shader reading chunk albedo and shadow masks from scene. Returned by value so every
+// caller shades with its own copy instead of pointing the shared ground_shadow_frag at a scene
+fragment_shader_t ground_shadow_shader(scene_t *scene) {
+  fragment_shader_t shader = ground_shadow_frag;
+  shader.argv = scene;
+  shader.argc = sizeof(scene_t);
+  return shader;
 }
 
 typedef struct {
-  int max_particles;
   float min_distance;
   float max_distance;
   float update_distance;
@@ -241,23 +250,36 @@ typedef struct {
   float sway_speed_max;
   float sway_amplitude;
   float quad_size;
-  float spawn_interval;
+  float fill_time;    // seconds spawning alone takes to grow an empty area to snow_particles flakes
   float frame_time;
 } particle_system_t;
 
+// Flakes live in parallel arrays so the per tick update is a few flat loops the compiler can
+// vectorize. Live flakes are kept packed in [0, count) and grow toward capacity, a flake that lands
+// is respawned in its slot and one that leaves the area is swapped with the last, so the simulation
+// never touches the allocator
+typedef struct {
+  float *xs, *ys, *zs;
+  float *fall_speeds;     // units per second
+  float *sway_phases;
+  float *sway_speeds;
+  int count, capacity;
+  float spawn_budget;     // flakes owed to the fill rate, spawned a whole batch per tick
+} snow_particles_t;
+
+// Flake positions render_quads draws, copied by snapshot_quads so ticks can move the flakes while
+// a render thread draws the previous positions. Only snapshot_quads writes it
 typedef struct {
-  model_t model;
-  float3 velocity;
-  float sway_time;
-  float sway_speed;
-  bool active;
-} falling_particle_t;
-
-#define MAX_PARTICLES 300
-static falling_particle_t particles[MAX_PARTICLES];
+  float *xs, *ys, *zs;
+  int count, capacity;
+} snow_view_t;
+
+static snow_particles_t snow = {0};
+static snow_view_t snow_view = {0};
+static snow_ground_t snow_ground = {0};
 static bool particles_initialized = false;
+static bool particles_failed = false;   // allocation failed once, snow stays off instead of retrying every tick
 static particle_system_t particle_system = {
-  .max_particles = 300,
   .min_distance = -8.0f,
   .max_distance = 50.0f,
   .update_distance = 45.0f,
@@ -269,25 +291,54 @@ static particle_system_t particle_system = {
   .sway_speed_max = 5.5f,
   .sway_amplitude = 0.75f,
   .quad_size = 0.2f,
-  .spawn_interval = 0.05f,
+  .fill_time = 15.0f,
   .frame_time = 0.016f
 };
 
-static void init_particles(particle_system_t *ps) {
-  for (int i = 0; i < ps->max_particles; i++) {
-    particles[i].model = (model_t){0};
-    particles[i].velocity = make_float3(0, 0, 0);
-    particles[i].sway_time = 0.0f;
-    particles[i].sway_speed = 0.0f;
-    particles[i].active = false;
+static bool init_particles(particle_system_t *ps) {
+  int capacity = g_world_config.snow_particles;
+
+  snow.xs = malloc(sizeof(float) * (usize)capacity);
+  snow.ys = malloc(sizeof(float) * (usize)capacity);
+  snow.zs = malloc(sizeof(float) * (usize)capacity);
+  snow.fall_speeds = malloc(sizeof(float) * (usize)capacity);
+  snow.sway_phases = malloc(sizeof(float) * (usize)capacity);
+  snow.sway_speeds = malloc(sizeof(float) * (usize)capacity);
+  int ground_failed = init_snow_ground(&snow_ground, ps->max_distance);
+
+  if ((capacity > 0 && (!snow.xs || !snow.ys || !snow.zs || !snow.fall_speeds || !snow.sway_phases || !snow.sway_speeds)) || ground_failed) {
+    printf("Failed to allocate %d snow particles, snow is disabled\n", capacity);
+    free_quads();
+    particles_failed = true;
+    return false;
   }
+
+  snow.count = 0;
+  snow.capacity = capacity;
+  snow.spawn_budget = 0.0f;
   particles_initialized = true;
+  return true;
 }
 
-static bool is_particle_in_range(float3 particle_pos, float3 center_pos, float radius) {
-  float dx = particle_pos.x - center_pos.x;
-  float dz = particle_pos.z - center_pos.z;
-  return (dx * dx + dz * dz) <= (radius * radius);
+void free_quads(void) {
+  free(snow.xs);
+  free(snow.ys);
+  free(snow.zs);
+  free(snow.fall_speeds);
+  free(snow.sway_phases);
+  free(snow.sway_speeds);
+  free(snow_view.xs);
+  free(snow_view.ys);
+  free(snow_view.zs);
+  free_snow_ground(&snow_ground);
+
+  snow = (snow_particles_t){0};
+  snow_view = (snow_view_t){0};
+  particles_initialized = false;
+}
+
+static float sample_terrain_height(void *args, float x, float z) {
+  return get_terrain_height((chunk_map_t *)args, x, z);
 }
 
 static float3 generate_spawn_position(particle_system_t *ps, float3 center, float radius) {
@@ -301,88 +352,132 @@ static float3 generate_spawn_position(particle_system_t *ps, float3 center, floa
   return make_float3(center.x + dx, center.y + height_offset, center.z + dz);
 }
 
-static void spawn_particle(particle_system_t *ps, int index, float3 player_pos, transform_t *camera_transform) {
-  (void)camera_transform;
-
+// (Re)initializes flake i in place, no mesh is built since render_quads splats the positions
+static void spawn_particle(particle_system_t *ps, int i, float3 player_pos) {
   float3 position = generate_spawn_position(ps, player_pos, ps->max_distance);
 
-  generate_quad(&particles[index].model, (float2){ps->quad_size, ps->quad_size}, position);
-  particles[index].model.frag_shader = &white_frag;
-  particles[index].model.vertex_shader = &billboard_vs;
-  particles[index].model.disable_behind_camera_culling = true;
-
-  float fall_speed = ps->fall_speed_min + rand_float() * (ps->fall_speed_max - ps->fall_speed_min);
-  particles[index].velocity = make_float3(0, -fall_speed, 0);
-  particles[index].sway_time = 0.0f;
-  particles[index].sway_speed = ps->sway_speed_min + rand_float() * (ps->sway_speed_max - ps->sway_speed_min);
-  particles[index].active = true;
+  snow.xs[i] = position.x;
+  snow.ys[i] = position.y;
+  snow.zs[i] = position.z;
+  snow.fall_speeds[i] = ps->fall_speed_min + rand_float() * (ps->fall_speed_max - ps->fall_speed_min);
+  snow.sway_phases[i] = 0.0f;
+  snow.sway_speeds[i] = ps->sway_speed_min + rand_float() * (ps->sway_speed_max - ps->sway_speed_min);
 }
 
-void update_quads(float3 player_pos, transform_t *camera_transform) {
+void update_quads(float3 player_pos, transform_t *camera_transform, chunk_map_t *chunk_map) {
+  (void)camera_transform;
   particle_system_t *ps = &particle_system;
 
   if (!particles_initialized) {
-    init_particles(ps);
-    for (int i = 0; i < ps->max_particles / 2; i++) {
-      spawn_particle(ps, i, player_pos, camera_transform);
+    if (particles_failed || !init_particles(ps)) return;
+    update_snow_ground(&snow_ground, player_pos.x, player_pos.z, sample_terrain_height, chunk_map);
+    while (snow.count < snow.capacity / 2) {
+      spawn_particle(ps, snow.count++, player_pos);
     }
     return;
   }
 
-  static float spawn_timer = 0.0f;
-  spawn_timer += ps->frame_time;
+  update_snow_ground(&snow_ground, player_pos.x, player_pos.z, sample_terrain_height, chunk_map);
 
-  for (int i = 0; i < ps->max_particles; i++) {
-    if (!particles[i].active) continue;
+  // flakes are added at capacity / fill_time per second, a whole batch per tick so large counts fill
+  // as quickly as small ones
+  snow.spawn_budget += (float)snow.capacity * ps->frame_time / ps->fill_time;
 
-    if (!is_particle_in_range(particles[i].model.transform.position, player_pos, ps->max_distance)) {
-      particles[i].active = false;
+  // flakes the player left behind are dropped, the last live flake takes their slot
+  float max_distance_sq = ps->max_distance * ps->max_distance;
+  for (int i = 0; i < snow.count;) {
+    float dx = snow.xs[i] - player_pos.x;
+    float dz = snow.zs[i] - player_pos.z;
+    if (dx * dx + dz * dz <= max_distance_sq) {
+      i++;
       continue;
     }
 
-    if (!is_particle_in_range(particles[i].model.transform.position, player_pos, ps->update_distance)) {
-      continue;
-    }
+    int last = --snow.count;
+    snow.xs[i] = snow.xs[last];
+    snow.ys[i] = snow.ys[last];
+    snow.zs[i] = snow.zs[last];
+    snow.fall_speeds[i] = snow.fall_speeds[last];
+    snow.sway_phases[i] = snow.sway_phases[last];
+    snow.sway_speeds[i] = snow.sway_speeds[last];
+  }
 
-    particles[i].sway_time += particles[i].sway_speed * ps->frame_time;
-    float sway_offset = sinf(particles[i].sway_time) * ps->sway_amplitude * ps->frame_time;
+  // flakes past update_distance hang in place, so the step is zero for them
+  float update_distance_sq = ps->update_distance * ps->update_distance;
+  float dt = ps->frame_time;
+  float sway = ps->sway_amplitude * ps->frame_time;
+  float *restrict xs = snow.xs, *restrict ys = snow.ys;
+  const float *restrict zs = snow.zs, *restrict fall_speeds = snow.fall_speeds, *restrict sway_speeds = snow.sway_speeds;
+  float *restrict sway_phases = snow.sway_phases;
+  for (int i = 0; i < snow.count; i++) {
+    float dx = xs[i] - player_pos.x;
+    float dz = zs[i] - player_pos.z;
+    float step = dx * dx + dz * dz <= update_distance_sq ? dt : 0.0f;
+
+    sway_phases[i] += sway_speeds[i] * step;
+    ys[i] -= fall_speeds[i] * step;
+  }
+  for (int i = 0; i < snow.count; i++) {
+    float dx = xs[i] - player_pos.x;
+    float dz = zs[i] - player_pos.z;
+    float amount = dx * dx + dz * dz <= update_distance_sq ? sway : 0.0f;
 
-    particles[i].model.transform.position.y += particles[i].velocity.y * ps->frame_time;
-    particles[i].model.transform.position.x += sway_offset;
+    xs[i] += sinf(sway_phases[i]) * amount;
+  }
 
-    float ground_height = get_interpolated_terrain_height(
-      particles[i].model.transform.position.x,
-      particles[i].model.transform.position.z
-    );
+  // flakes that reached the ground start over above the player, those hanging past update_distance
+  // are not tested
+  for (int i = 0; i < snow.count; i++) {
+    float dx = xs[i] - player_pos.x;
+    float dz = zs[i] - player_pos.z;
+    if (dx * dx + dz * dz > update_distance_sq) continue;
 
-    if (particles[i].model.transform.position.y <= ground_height + 0.5f) {
-      spawn_particle(ps, i, player_pos, camera_transform);
+    if (ys[i] <= snow_ground_height(&snow_ground, xs[i], zs[i]) + 0.5f) {
+      spawn_particle(ps, i, player_pos);
     }
   }
 
-  if (spawn_timer > ps->spawn_interval) {
-    for (int i = 0; i < ps->max_particles; i++) {
-      if (!particles[i].active) {
-        spawn_particle(ps, i, player_pos, camera_transform);
-        break;
-      }
-    }
-    spawn_timer = 0.0f;
+  int batch = (int)snow.spawn_budget;
+  snow.spawn_budget -= (float)batch;
+  if (batch > snow.capacity - snow.count) batch = snow.capacity - snow.count;
+  for (int i = 0; i < batch; i++) {
+    spawn_particle(ps, snow.count++, player_pos);
   }
 }
 
-usize render_quads(renderer_t *renderer, transform_t *camera, light_t *lights, usize num_lights) {
-  particle_system_t *ps = &particle_system;
-  usize total_triangles = 0;
+void snapshot_quads(void) {
+  if (snow_view.capacity < snow.count) {
+    float *xs = realloc(snow_view.xs, sizeof(float) * (usize)snow.capacity);
+    if (xs) snow_view.xs = xs;
+    float *ys = realloc(snow_view.ys, sizeof(float) * (usize)snow.capacity);
+    if (ys) snow_view.ys = ys;
+    float *zs = realloc(snow_view.zs, sizeof(float) * (usize)snow.capacity);
+    if (zs) snow_view.zs = zs;
 
-  for (int i = 0; i < ps->max_particles; i++) {
-    if (particles[i].active && particles[i].model.vertex_data) {
-      usize triangles = render_model(renderer, camera, &particles[i].model, lights, num_lights);
-      total_triangles += triangles;
-    }
+    snow_view.capacity = xs && ys && zs ? snow.capacity : 0;
   }
 
-  return total_triangles;
+  snow_view.count = snow.count <= snow_view.capacity ? snow.count : 0;
+  if (snow_view.count == 0) return;
+
+  memcpy(snow_view.xs, snow.xs, sizeof(float) * (usize)snow_view.count);
+  memcpy(snow_view.ys, snow.ys, sizeof(float) * (usize)snow_view.count);
+  memcpy(snow_view.zs, snow.zs, sizeof(float) * (usize)snow_view.count);
+}
+
+usize render_quads(renderer_t *renderer, transform_t *camera, render_pass_t pass) {
+  particle_system_t *ps = &particle_system;
+
+  // flakes are unlit white squares, so they skip render_model and are splatted as point sprites
+  screen_projection_t projection;
+  init_screen_projection(&projection, renderer, camera);
+
+  // the visibility pass leaves the snow id for resolve_visibility_buffer to shade
+  u32 color = pass == RENDER_PASS_VISIBILITY ? snow_visibility_id() : rgb_to_u32(255, 255, 255);
+  usize pixels = render_point_sprites(renderer, &projection, snow_view.xs, snow_view.ys, snow_view.zs, (usize)snow_view.count, ps->quad_size, color);
+  if (pass == RENDER_PASS_FORWARD) count_shaded_fragments(pixels);
+
+  return (usize)snow_view.count;
 }
 
 
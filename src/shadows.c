@@ -0,0 +1,195 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <shader-works/maths.h>
+
+#include "scene.h"
+
+// Tree shadows are baked per chunk into a coverage mask by projecting every tree triangle of the chunk
+// and its 8 neighbours along the sun direction onto the ground. A mask is rebuilt when the sun moves
+// or the set of loaded neighbours changes, a few masks per update_shadow_masks call so bursts of loads are spread out.
+
+#define MAX_SHADOW_REBUILDS_PER_TICK 2
+
+// sun elevations below this cast shadows too long for one neighbouring chunk, they are skipped
+#define MIN_SHADOW_SUN_Y 0.1f
+
+// bit (dz + 1) * 3 + (dx + 1) is set when that neighbour (or the chunk itself) is loaded
+static u16 loaded_neighbours(chunk_map_t *map, const chunk_t *chunk) {
+  u16 bits = 0;
+
+  for (int dz = -1; dz <= 1; dz++) {
+    for (int dx = -1; dx <= 1; dx++) {
+      if (is_chunk_loaded(map, chunk->x + dx, chunk->z + dz)) {
+        bits |= (u16)(1u << ((dz + 1) * 3 + (dx + 1)));
+      }
+    }
+  }
+
+  return bits;
+}
+
+static inline bool same_direction(float3 a, float3 b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static inline float edge(float2 a, float2 b, float px, float pz) {
+  return (b.x - a.x) * (pz - a.y) - (b.y - a.y) * (px - a.x);
+}
+
+// Mark every texel whose center lies inside triangle abc, coordinates are in texels
+static void rasterize_triangle(u8 *mask, int size, float2 a, float2 b, float2 c) {
+  float area = edge(a, b, c.x, c.y);
+  if (fabsf(area) < 1e-6f) return;
+
+  int min_x = (int)floorf(fminf(a.x, fminf(b.x, c.x)));
+  int max_x = (int)ceilf(fmaxf(a.x, fmaxf(b.x, c.x)));
+  int min_z = (int)floorf(fminf(a.y, fminf(b.y, c.y)));
+  int max_z = (int)ceilf(fmaxf(a.y, fmaxf(b.y, c.y)));
+
+  if (max_x < 0 || max_z < 0 || min_x >= size || min_z >= size) return;
+  if (min_x < 0) min_x = 0;
+  if (min_z < 0) min_z = 0;
+  if (max_x > size - 1) max_x = size - 1;
+  if (max_z > size - 1) max_z = size - 1;
+
+  // orient so inside is positive for either winding
+  float sign = area > 0.0f ? 1.0f : -1.0f;
+
+  for (int z = min_z; z <= max_z; ++z) {
+    float pz = (float)z + 0.5f;
+
+    for (int x = min_x; x <= max_x; ++x) {
+      float px = (float)x + 0.5f;
+
+      if (edge(a, b, px, pz) * sign >= 0.0f && edge(b, c, px, pz) * sign >= 0.0f && edge(c, a, px, pz) * sign >= 0.0f) {
+        mask[z * size + x] = 1;
+      }
+    }
+  }
+}
+
+// Project a tree onto the plane of its base along sun and rasterize it into the target chunk's mask,
+// projected needs room for one entry per vertex of the archetype's mesh
+static void rasterize_tree(chunk_t *target, const tree_instance_t *instance, float3 sun, float2 *projected) {
+  const tree_archetype_t *archetype = tree_archetype(instance->archetype);
+  if (!archetype) return;
+
+  const indexed_mesh_t *tree = &archetype->mesh;
+  float origin_x = (float)(target->x * g_world_config.chunk_size);
+  float origin_z = (float)(target->z * g_world_config.chunk_size);
+
+  float3 tree_min, tree_max;
+  tree_instance_bounds(instance, archetype, &tree_min, &tree_max);
+
+  // the shadow lies between the bounds' footprint and that footprint moved along the sun to the bottom
+  float reach = (tree_max.y - tree_min.y) / -sun.y;
+  float shadow_min_x = tree_min.x + fminf(0.0f, sun.x * reach);
+  float shadow_max_x = tree_max.x + fmaxf(0.0f, sun.x * reach);
+  float shadow_min_z = tree_min.z + fminf(0.0f, sun.z * reach);
+  float shadow_max_z = tree_max.z + fmaxf(0.0f, sun.z * reach);
+
+  if (shadow_max_x < origin_x || shadow_min_x > origin_x + g_world_config.chunk_size ||
+      shadow_max_z < origin_z || shadow_min_z > origin_z + g_world_config.chunk_size) {
+    return;
+  }
+
+  float texels_per_unit = (float)target->shadow_size / (float)g_world_config.chunk_size;
+
+  // archetype vertices are relative to the base, the instance's turn and scale are applied about
+  // a base at the texel origin so the world offset is folded in afterwards
+  tree_transform_t transform = tree_instance_transform(instance);
+  transform.position = make_float3(0, 0, 0);
+  float offset_x = instance->position.x - origin_x;
+  float offset_z = instance->position.z - origin_z;
+  float offset_y = instance->position.y - tree_min.y;
+
+  // shared vertices are projected once, the triangles then only gather them
+  for (usize v = 0; v < tree->num_vertices; ++v) {
+    float3 p = tree_transform_point(&transform, tree->vertices[v].position);
+    float t = (p.y + offset_y) / -sun.y;
+
+    projected[v] = make_float2((p.x + sun.x * t + offset_x) * texels_per_unit,
+                               (p.z + sun.z * t + offset_z) * texels_per_unit);
+  }
+
+  for (usize i = 0; i + 2 < tree->num_indices; i += 3) {
+    rasterize_triangle(target->shadow_mask, target->shadow_size, projected[tree->indices[i]], projected[tree->indices[i + 1]], projected[tree->indices[i + 2]]);
+  }
+}
+
+// projected holds tree_library_max_vertices entries
+static void rebuild_shadow_mask(chunk_map_t *map, chunk_t *chunk, float3 sun_direction, u16 neighbours, float2 *projected) {
+  int size = g_world_config.chunk_size * g_world_config.tree_shadow_texels_per_unit;
+
+  // the size is fixed by the config, so the mask is allocated from the chunk's arena once
+  if (!chunk->shadow_mask) {
+    chunk->shadow_mask = chunk_arena_alloc(chunk->arena, (usize)size * size);
+    chunk->shadow_size = chunk->shadow_mask ? size : 0;
+  }
+
+  chunk->shadow_sun = sun_direction;
+  chunk->shadow_neighbours = neighbours;
+  if (!chunk->shadow_mask) return;
+
+  memset(chunk->shadow_mask, 0, (usize)chunk->shadow_size * chunk->shadow_size);
+
+  float3 sun = float3_normalize(sun_direction);
+  if (sun.y > -MIN_SHADOW_SUN_Y) return;
+
+  for (int dz = -1; dz <= 1; dz++) {
+    for (int dx = -1; dx <= 1; dx++) {
+      chunk_map_node_t *node = chunk_lookup(map, chunk->x + dx, chunk->z + dz);
+      if (!node || !node->loaded) continue;
+
+      for (usize i = 0; i < node->chunk.num_trees; ++i) {
+        rasterize_tree(chunk, &node->chunk.tree_instances[i], sun, projected);
+      }
+    }
+  }
+}
+
+void update_shadow_masks(scene_t *scene) {
+  if (!scene || g_world_config.tree_shadow_texels_per_unit <= 0) return;
+
+  // every tree vertex is projected through this, sized once for the library's largest mesh
+  chunk_t **chunks = calloc(g_world_config.max_chunks, sizeof(chunk_t*));
+  float2 *projected = malloc((tree_library_max_vertices() + 1) * sizeof(float2));
+  if (!chunks || !projected) {
+    free(chunks);
+    free(projected);
+    return;
+  }
+
+  usize chunk_count = 0;
+  get_all_chunks(&scene->chunk_map, chunks, &chunk_count);
+
+  usize rebuilt = 0;
+  for (usize i = 0; i < chunk_count && rebuilt < MAX_SHADOW_REBUILDS_PER_TICK; ++i) {
+    chunk_t *chunk = chunks[i];
+    if (!chunk || !chunk->arena) continue;
+
+    u16 neighbours = loaded_neighbours(&scene->chunk_map, chunk);
+    if (chunk->shadow_mask && chunk->shadow_neighbours == neighbours && same_direction(chunk->shadow_sun, scene->sun.direction)) {
+      continue;
+    }
+
+    rebuild_shadow_mask(&scene->chunk_map, chunk, scene->sun.direction, neighbours, projected);
+    rebuilt++;
+  }
+
+  free(chunks);
+  free(projected);
+}
+
+bool chunk_in_tree_shadow(const chunk_t *chunk, float x, float z) {
+  if (!chunk || !chunk->shadow_mask) return false;
+
+  float texels_per_unit = (float)chunk->shadow_size / (float)g_world_config.chunk_size;
+  int tx = (int)((x - (float)(chunk->x * g_world_config.chunk_size)) * texels_per_unit);
+  int tz = (int)((z - (float)(chunk->z * g_world_config.chunk_size)) * texels_per_unit);
+
+  if (tx < 0 || tz < 0 || tx >= chunk->shadow_size || tz >= chunk->shadow_size) return false;
+  return chunk->shadow_mask[tz * chunk->shadow_size + tx] != 0;
+}
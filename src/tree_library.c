@@ -0,0 +1,226 @@
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <shader-works/maths.h>
+#include <shader-works/primitives.h>
+
+#include "scene.h"
+
+// Trees are not generated per chunk. The library holds one mesh for every combination of trunk
+// segments, branches and levels generate_chunk can pick, times tree_archetype_variants variants with
+// their own radius, lean and branch chance. Chunks store a base position, archetype id, turn and
+// scale per tree. The archetype's mesh is baked at TREE_SCALE_STEPS scales and drawn there as is,
+// turned by the model's transform, the impostor is turned and scaled by its shaders.
+
+#define MIN_TREE_SEGMENTS 4
+#define MAX_TREE_SEGMENTS 5
+#define MIN_TREE_BRANCHES 3
+#define MAX_TREE_BRANCHES 6
+#define MIN_TREE_LEVELS 4
+#define MAX_TREE_LEVELS 5
+
+#define NUM_TREE_SEGMENTS (MAX_TREE_SEGMENTS - MIN_TREE_SEGMENTS + 1)
+#define NUM_TREE_BRANCHES (MAX_TREE_BRANCHES - MIN_TREE_BRANCHES + 1)
+#define NUM_TREE_LEVELS (MAX_TREE_LEVELS - MIN_TREE_LEVELS + 1)
+#define NUM_TREE_KEYS (NUM_TREE_SEGMENTS * NUM_TREE_BRANCHES * NUM_TREE_LEVELS)
+
+extern int generate_tree(indexed_mesh_t *, float, float, float3, float, usize, const usize, const usize, const usize); // in proc_gen.c
+
+// Built by init_tree_library before the chunk workers start, read only afterwards
+static struct {
+  tree_archetype_t *archetypes;
+  usize num_archetypes, variants;
+  usize max_vertices;   // most shared vertices of any archetype's mesh
+} library;
+
+static inline usize clamp_param(usize value, usize min, usize max) {
+  return value < min ? min : (value > max ? max : value);
+}
+
+// The mesh as a triangle list scaled about its base, face normals are shared with the archetype
+// since a uniform scale leaves them as they are
+static int bake_scaled_model(tree_archetype_t *archetype, float scale, model_t *out) {
+  const indexed_mesh_t *mesh = &archetype->mesh;
+  vertex_data_t *vertices = malloc(mesh->num_indices * sizeof(vertex_data_t));
+  if (!vertices) return -1;
+
+  indexed_mesh_expand(mesh, mesh->vertices, vertices);
+  for (usize v = 0; v < mesh->num_indices; ++v) {
+    vertices[v].position = float3_scale(vertices[v].position, scale);
+  }
+
+  *out = (model_t){0};
+  out->vertex_data = vertices;
+  out->face_normals = archetype->face_normals;
+  out->num_vertices = mesh->num_indices;
+  out->num_faces = mesh->num_indices / 3;
+  return 0;
+}
+
+static void free_archetype(tree_archetype_t *archetype) {
+  free_indexed_mesh(&archetype->mesh);
+  free(archetype->face_normals);
+  archetype->face_normals = NULL;
+  for (usize step = 0; step < TREE_SCALE_STEPS; ++step) {
+    free(archetype->models[step].vertex_data);
+    archetype->models[step] = (model_t){0};
+  }
+  free_tree_impostor(&archetype->impostor);
+}
+
+static int generate_archetype(tree_archetype_t *archetype, usize id, usize segments, usize max_branches, usize num_levels, usize variant) {
+  float t = ((float)variant + 0.5f) / (float)library.variants;
+  float base_radius = lerp(0.4f, 0.55f, t);
+  float base_angle = t * 2.0f * PI;
+
+  // generate_chunk scales the branch chance by the LOD factor that also drops to 4 segments, which
+  // always clamps it to 0.75
+  float branch_chance = segments == MAX_TREE_SEGMENTS ? lerp(0.85f, 0.95f, t) : 0.75f;
+
+  // generate_tree seeds its shape from the base position, so each archetype grows at its own spot
+  // and is then moved to the origin
+  float3 grown_at = make_float3(1000.0f + (float)id * 53.0f, 0.0f, 1000.0f + (float)id * 97.0f);
+
+  indexed_mesh_t *mesh = &archetype->mesh;
+  generate_tree(mesh, base_radius, base_angle, grown_at, branch_chance, 0, max_branches, num_levels, segments);
+  if (mesh->num_indices == 0) {
+    free_indexed_mesh(mesh);
+    return -1;
+  }
+
+  indexed_mesh_trim(mesh);
+  archetype->radius = base_radius;
+
+  for (usize v = 0; v < mesh->num_vertices; ++v) {
+    float3 p = float3_sub(mesh->vertices[v].position, grown_at);
+    mesh->vertices[v].position = p;
+
+    if (v == 0) {
+      archetype->aabb_min = archetype->aabb_max = p;
+      continue;
+    }
+    archetype->aabb_min = make_float3(fminf(archetype->aabb_min.x, p.x), fminf(archetype->aabb_min.y, p.y), fminf(archetype->aabb_min.z, p.z));
+    archetype->aabb_max = make_float3(fmaxf(archetype->aabb_max.x, p.x), fmaxf(archetype->aabb_max.y, p.y), fmaxf(archetype->aabb_max.z, p.z));
+  }
+
+  archetype->face_normals = malloc(mesh->num_indices / 3 * sizeof(float3));
+  if (!archetype->face_normals) {
+    free_indexed_mesh(mesh);
+    return -1;
+  }
+  indexed_mesh_face_normals(mesh, archetype->face_normals);
+
+  for (usize step = 0; step < TREE_SCALE_STEPS; ++step) {
+    if (bake_scaled_model(archetype, tree_scale_step_scale(step), &archetype->models[step]) != 0) {
+      free_archetype(archetype);
+      return -1;
+    }
+  }
+
+  // the impostor baker reads a triangle list, which is only kept while it runs. A tree without an
+  // impostor is drawn as a mesh at every distance
+  model_t baked = {0};
+  if (indexed_mesh_to_model(mesh, &baked) == 0) {
+    generate_tree_impostor(&archetype->impostor, &baked, make_float3(0, 0, 0), archetype->aabb_min, archetype->aabb_max);
+    delete_model(&baked);
+  }
+
+  if (mesh->num_vertices > library.max_vertices) library.max_vertices = mesh->num_vertices;
+  return 0;
+}
+
+int init_tree_library(void) {
+  library.variants = g_world_config.tree_archetype_variants > 0 ? (usize)g_world_config.tree_archetype_variants : 1;
+  library.num_archetypes = NUM_TREE_KEYS * library.variants;
+  library.archetypes = calloc(library.num_archetypes, sizeof(tree_archetype_t));
+  if (!library.archetypes) {
+    library.num_archetypes = 0;
+    return -1;
+  }
+
+  for (usize segments = MIN_TREE_SEGMENTS; segments <= MAX_TREE_SEGMENTS; ++segments) {
+    for (usize branches = MIN_TREE_BRANCHES; branches <= MAX_TREE_BRANCHES; ++branches) {
+      for (usize levels = MIN_TREE_LEVELS; levels <= MAX_TREE_LEVELS; ++levels) {
+        for (usize variant = 0; variant < library.variants; ++variant) {
+          u16 id = tree_archetype_id(segments, branches, levels, variant);
+          generate_archetype(&library.archetypes[id], id, segments, branches, levels, variant);
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+void free_tree_library(void) {
+  for (usize i = 0; i < library.num_archetypes; ++i) {
+    free_archetype(&library.archetypes[i]);
+  }
+
+  free(library.archetypes);
+  library.archetypes = NULL;
+  library.num_archetypes = 0;
+  library.max_vertices = 0;
+}
+
+// Parameters outside the library's range are clamped to the nearest archetype
+u16 tree_archetype_id(usize segments, usize max_branches, usize num_levels, usize variant) {
+  segments = clamp_param(segments, MIN_TREE_SEGMENTS, MAX_TREE_SEGMENTS) - MIN_TREE_SEGMENTS;
+  max_branches = clamp_param(max_branches, MIN_TREE_BRANCHES, MAX_TREE_BRANCHES) - MIN_TREE_BRANCHES;
+  num_levels = clamp_param(num_levels, MIN_TREE_LEVELS, MAX_TREE_LEVELS) - MIN_TREE_LEVELS;
+  if (variant >= library.variants) variant = library.variants - 1;
+
+  usize key = (segments * NUM_TREE_BRANCHES + max_branches) * NUM_TREE_LEVELS + num_levels;
+  return (u16)(key * library.variants + variant);
+}
+
+// NULL for ids outside the library and for archetypes that failed to generate
+tree_archetype_t *tree_archetype(u16 id) {
+  if (id >= library.num_archetypes || !library.archetypes[id].face_normals) return NULL;
+  return &library.archetypes[id];
+}
+
+// World space box around an instance, the archetype's footprint corners are turned with the tree
+void tree_instance_bounds(const tree_instance_t *instance, const tree_archetype_t *archetype, float3 *out_min, float3 *out_max) {
+  tree_transform_t transform = tree_instance_transform(instance);
+  float3 lo = make_float3(FLT_MAX, instance->position.y + archetype->aabb_min.y * transform.scale, FLT_MAX);
+  float3 hi = make_float3(-FLT_MAX, instance->position.y + archetype->aabb_max.y * transform.scale, -FLT_MAX);
+
+  for (usize corner = 0; corner < 4; ++corner) {
+    float3 local = make_float3(corner & 1 ? archetype->aabb_max.x : archetype->aabb_min.x, 0.0f,
+                               corner & 2 ? archetype->aabb_max.z : archetype->aabb_min.z);
+    float3 p = tree_transform_point(&transform, local);
+    lo.x = fminf(lo.x, p.x);
+    lo.z = fminf(lo.z, p.z);
+    hi.x = fmaxf(hi.x, p.x);
+    hi.z = fmaxf(hi.z, p.z);
+  }
+
+  *out_min = lo;
+  *out_max = hi;
+}
+
+usize tree_library_variants(void) {
+  return library.variants;
+}
+
+usize tree_library_max_vertices(void) {
+  return library.max_vertices;
+}
+
+usize tree_library_memory_size(void) {
+  usize size = library.num_archetypes * sizeof(tree_archetype_t);
+
+  for (usize i = 0; i < library.num_archetypes; ++i) {
+    const indexed_mesh_t *mesh = &library.archetypes[i].mesh;
+    size += indexed_mesh_memory_size(mesh);
+    if (library.archetypes[i].face_normals) {
+      size += mesh->num_indices / 3 * sizeof(float3);
+      size += TREE_SCALE_STEPS * mesh->num_indices * sizeof(vertex_data_t);
+    }
+    size += tree_impostor_memory_size(&library.archetypes[i].impostor);
+  }
+
+  return size;
+}
@@ -0,0 +1,145 @@
+#include "chunk_arena.h"
+
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#define CHUNK_ARENA_ALIGNMENT 16
+
+typedef struct {
+  chunk_arena_t *free_list;
+  usize num_free, max_pooled;
+  usize arena_size;
+
+  chunk_arena_t *retired;   // released while reuse was deferred, linked through next_free
+  bool defer_reuse;
+
+  usize created, recycled;
+  SDL_Mutex *lock;
+} chunk_arena_pool_t;
+
+static chunk_arena_pool_t pool = {0};
+
+void *chunk_arena_alloc(chunk_arena_t *arena, usize size) {
+  if (!arena || size == 0) return NULL;
+
+  usize offset = (arena->used + CHUNK_ARENA_ALIGNMENT - 1) & ~(usize)(CHUNK_ARENA_ALIGNMENT - 1);
+  if (offset > arena->capacity || size > arena->capacity - offset) return NULL;
+
+  arena->used = offset + size;
+  return arena->base + offset;
+}
+
+static void destroy_arena(chunk_arena_t *arena) {
+  free(arena->base);
+  free(arena);
+}
+
+void init_chunk_arena_pool(usize max_pooled, usize arena_size) {
+  if (pool.lock) return;
+
+  pool = (chunk_arena_pool_t){
+    .max_pooled = max_pooled,
+    .arena_size = arena_size,
+    .lock = SDL_CreateMutex()
+  };
+}
+
+void free_chunk_arena_pool(void) {
+  if (!pool.lock) return;
+
+  while (pool.free_list) {
+    chunk_arena_t *next = pool.free_list->next_free;
+    destroy_arena(pool.free_list);
+    pool.free_list = next;
+  }
+  while (pool.retired) {
+    chunk_arena_t *next = pool.retired->next_free;
+    destroy_arena(pool.retired);
+    pool.retired = next;
+  }
+
+  SDL_DestroyMutex(pool.lock);
+  pool = (chunk_arena_pool_t){0};
+}
+
+chunk_arena_t *chunk_arena_acquire(void) {
+  if (!pool.lock) return NULL;
+
+  SDL_LockMutex(pool.lock);
+  chunk_arena_t *arena = pool.free_list;
+  if (arena) {
+    pool.free_list = arena->next_free;
+    pool.num_free--;
+    pool.recycled++;
+  }
+  SDL_UnlockMutex(pool.lock);
+
+  if (arena) {
+    arena->next_free = NULL;
+    return arena;
+  }
+
+  // pool is empty, grow it outside the lock
+  arena = malloc(sizeof(chunk_arena_t));
+  if (!arena) return NULL;
+
+  *arena = (chunk_arena_t){ .base = malloc(pool.arena_size), .capacity = pool.arena_size };
+  if (!arena->base) {
+    free(arena);
+    return NULL;
+  }
+
+  SDL_LockMutex(pool.lock);
+  pool.created++;
+  SDL_UnlockMutex(pool.lock);
+
+  return arena;
+}
+
+void chunk_arena_release(chunk_arena_t *arena) {
+  if (!arena) return;
+
+  arena->used = 0;
+
+  SDL_LockMutex(pool.lock);
+  if (pool.defer_reuse) {
+    arena->next_free = pool.retired;
+    pool.retired = arena;
+    SDL_UnlockMutex(pool.lock);
+    return;
+  }
+
+  bool keep = pool.num_free < pool.max_pooled;
+  if (keep) {
+    arena->next_free = pool.free_list;
+    pool.free_list = arena;
+    pool.num_free++;
+  }
+  SDL_UnlockMutex(pool.lock);
+
+  if (!keep) destroy_arena(arena);
+}
+
+void chunk_arena_pool_defer_reuse(bool defer) {
+  if (!pool.lock) return;
+
+  SDL_LockMutex(pool.lock);
+  pool.defer_reuse = defer;
+  chunk_arena_t *retired = defer ? NULL : pool.retired;
+  if (!defer) pool.retired = NULL;
+  SDL_UnlockMutex(pool.lock);
+
+  while (retired) {
+    chunk_arena_t *next = retired->next_free;
+    chunk_arena_release(retired);
+    retired = next;
+  }
+}
+
+void chunk_arena_pool_stats(usize *created, usize *recycled) {
+  SDL_LockMutex(pool.lock);
+  if (created) *created = pool.created;
+  if (recycled) *recycled = pool.recycled;
+  SDL_UnlockMutex(pool.lock);
+}
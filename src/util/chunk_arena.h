@@ -0,0 +1,34 @@
+#ifndef __CHUNK_ARENA_H__
+#define __CHUNK_ARENA_H__
+
+#include <shader-works/maths.h>
+
+// Bump allocator holding everything generated for one chunk, released as a whole
+typedef struct chunk_arena_t {
+  u8 *base;
+  usize capacity, used;
+  struct chunk_arena_t *next_free;
+} chunk_arena_t;
+
+// 16 byte aligned block from the arena, NULL once the arena is full
+void *chunk_arena_alloc(chunk_arena_t *arena, usize size);
+
+// Arenas are shared by the chunk workers and the main thread through one pool. Released arenas
+// are kept for reuse up to max_pooled, any beyond that (chunks held by the eviction cache) are freed
+void init_chunk_arena_pool(usize max_pooled, usize arena_size);
+void free_chunk_arena_pool(void);
+
+// Empty arena of the pool's size, NULL when out of memory
+chunk_arena_t *chunk_arena_acquire(void);
+
+// O(1) reset, the arena's memory goes to the next chunk acquired
+void chunk_arena_release(chunk_arena_t *arena);
+
+// While deferred, released arenas are parked instead of going back to the pool, so chunks another
+// thread is still drawing from a snapshot stay intact. Ending the deferral releases them
+void chunk_arena_pool_defer_reuse(bool defer);
+
+// Arenas created since init and acquisitions served by a recycled arena
+void chunk_arena_pool_stats(usize *created, usize *recycled);
+
+#endif
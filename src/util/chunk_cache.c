@@ -0,0 +1,94 @@
+#include "chunk_cache.h"
+
+#include <stdlib.h>
+
+void init_chunk_cache(chunk_cache_t *cache, usize budget_bytes) {
+  if (!cache) return;
+
+  *cache = (chunk_cache_t){0};
+  cache->budget_bytes = budget_bytes;
+}
+
+void free_chunk_cache(chunk_cache_t *cache) {
+  if (!cache) return;
+
+  for (usize i = 0; i < cache->count; ++i) {
+    free_chunk(&cache->chunks[i]);
+  }
+
+  free(cache->chunks);
+  free(cache->last_used);
+  free(cache->sizes);
+
+  init_chunk_cache(cache, cache->budget_bytes);
+}
+
+// swap-remove entry i, the caller owns or has freed its chunk
+static void remove_entry(chunk_cache_t *cache, usize i) {
+  cache->bytes_used -= cache->sizes[i];
+  cache->count--;
+
+  cache->chunks[i] = cache->chunks[cache->count];
+  cache->last_used[i] = cache->last_used[cache->count];
+  cache->sizes[i] = cache->sizes[cache->count];
+}
+
+static void evict_oldest(chunk_cache_t *cache) {
+  usize oldest = 0;
+  for (usize i = 1; i < cache->count; ++i) {
+    if (cache->last_used[i] < cache->last_used[oldest]) oldest = i;
+  }
+
+  free_chunk(&cache->chunks[oldest]);
+  remove_entry(cache, oldest);
+}
+
+static bool grow(chunk_cache_t *cache) {
+  usize capacity = cache->capacity ? cache->capacity * 2 : 16;
+
+  chunk_t *chunks = realloc(cache->chunks, capacity * sizeof(chunk_t));
+  if (chunks) cache->chunks = chunks;
+  uint64_t *last_used = realloc(cache->last_used, capacity * sizeof(uint64_t));
+  if (last_used) cache->last_used = last_used;
+  usize *sizes = realloc(cache->sizes, capacity * sizeof(usize));
+  if (sizes) cache->sizes = sizes;
+
+  if (!chunks || !last_used || !sizes) return false;
+
+  cache->capacity = capacity;
+  return true;
+}
+
+void chunk_cache_put(chunk_cache_t *cache, chunk_t *chunk) {
+  if (!cache || !chunk) return;
+
+  usize size = chunk_memory_size(chunk);
+  if (size > cache->budget_bytes || (cache->count == cache->capacity && !grow(cache))) {
+    free_chunk(chunk);
+    return;
+  }
+
+  while (cache->count > 0 && cache->bytes_used + size > cache->budget_bytes) {
+    evict_oldest(cache);
+  }
+
+  cache->chunks[cache->count] = *chunk;
+  cache->last_used[cache->count] = ++cache->clock;
+  cache->sizes[cache->count] = size;
+  cache->bytes_used += size;
+  cache->count++;
+}
+
+bool chunk_cache_take(chunk_cache_t *cache, int x, int z, chunk_t *out) {
+  if (!cache || !out) return false;
+
+  for (usize i = 0; i < cache->count; ++i) {
+    if (cache->chunks[i].x == x && cache->chunks[i].z == z) {
+      *out = cache->chunks[i];
+      remove_entry(cache, i);
+      return true;
+    }
+  }
+
+  return false;
+}
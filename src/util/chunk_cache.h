@@ -0,0 +1,26 @@
+#ifndef __CHUNK_CACHE_H__
+#define __CHUNK_CACHE_H__
+
+#include "chunk_map.h"
+
+// Least recently evicted chunks, kept around so turning back does not regenerate them
+typedef struct {
+  chunk_t *chunks;
+  uint64_t *last_used;
+  usize *sizes;
+  usize count, capacity;
+
+  usize bytes_used, budget_bytes;
+  uint64_t clock;
+} chunk_cache_t;
+
+void init_chunk_cache(chunk_cache_t *cache, usize budget_bytes);
+void free_chunk_cache(chunk_cache_t *cache);
+
+// Take ownership of an evicted chunk, frees the oldest entries while over budget
+void chunk_cache_put(chunk_cache_t *cache, chunk_t *chunk);
+
+// Move a cached chunk back out, returns false on a miss
+bool chunk_cache_take(chunk_cache_t *cache, int x, int z, chunk_t *out);
+
+#endif
@@ -1,33 +1,111 @@
 #include "chunk_map.h"
+#include "config.h"
 
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
-static inline usize get_chunk_hash(int x, int z, usize table_size) {
-  return ((x * 73856093) ^ (z * 19349663)) % table_size;
+extern tree_archetype_t *tree_archetype(u16);   // in tree_library.c
+extern void tree_instance_bounds(const tree_instance_t *, const tree_archetype_t *, float3 *, float3 *);  // in tree_library.c
+
+void free_chunk(chunk_t *chunk) {
+  if (!chunk) return;
+
+  chunk_arena_release(chunk->arena);
+  chunk->arena = NULL;
+
+  chunk->heights = NULL;
+  chunk->albedo = NULL;
+  chunk->albedo_size = 0;
+  chunk->shadow_mask = NULL;
+  chunk->shadow_size = 0;
+
+  for (usize i = 0; i < MAX_GROUND_LODS; ++i) {
+    chunk->ground_lods[i] = (model_t){0};
+  }
+
+  chunk->tree_instances = NULL;
+  chunk->num_trees = 0;
+}
+
+usize chunk_memory_size(const chunk_t *chunk) {
+  if (!chunk || !chunk->arena) return 0;
+  return chunk->arena->capacity;
+}
+
+static inline int tree_grid_cell(float local, float cell_size) {
+  int cell = (int)floorf(local / cell_size);
+  return cell < 0 ? 0 : (cell >= TREE_GRID_DIM ? TREE_GRID_DIM - 1 : cell);
+}
+
+void build_tree_grid(chunk_t *chunk) {
+  if (!chunk) return;
+
+  memset(chunk->tree_grid, 0, sizeof(chunk->tree_grid));
+  if (!chunk->tree_instances) return;
+
+  float cell_size = (float)g_world_config.chunk_size / TREE_GRID_DIM;
+  float origin_x = (float)(chunk->x * g_world_config.chunk_size);
+  float origin_z = (float)(chunk->z * g_world_config.chunk_size);
+
+  for (usize i = 0; i < chunk->num_trees; ++i) {
+    const tree_instance_t *tree = &chunk->tree_instances[i];
+    const tree_archetype_t *archetype = tree_archetype(tree->archetype);
+    if (!archetype) continue;
+
+    float3 tree_min, tree_max;
+    tree_instance_bounds(tree, archetype, &tree_min, &tree_max);
+
+    // bounds past the chunk edge are clamped into the border cells
+    int min_x = tree_grid_cell(tree_min.x - origin_x, cell_size);
+    int max_x = tree_grid_cell(tree_max.x - origin_x, cell_size);
+    int min_z = tree_grid_cell(tree_min.z - origin_z, cell_size);
+    int max_z = tree_grid_cell(tree_max.z - origin_z, cell_size);
+
+    for (int z = min_z; z <= max_z; ++z) {
+      for (int x = min_x; x <= max_x; ++x) {
+        chunk->tree_grid[z * TREE_GRID_DIM + x] |= (u8)(1u << i);
+      }
+    }
+  }
 }
 
-static void free_chunk_node(chunk_map_node_t *node) {
-  if (!node) return;
+u8 trees_near(const chunk_t *chunk, float x, float z, float radius) {
+  if (!chunk) return 0;
 
-  delete_model(&node->chunk.ground_plane);
+  float cell_size = (float)g_world_config.chunk_size / TREE_GRID_DIM;
+  float local_x = x - (float)(chunk->x * g_world_config.chunk_size);
+  float local_z = z - (float)(chunk->z * g_world_config.chunk_size);
 
-  for (usize i = 0; i < node->chunk.num_trees; ++i) {
-    delete_model(&node->chunk.trees[i]);
+  if (local_x + radius < 0.0f || local_z + radius < 0.0f ||
+      local_x - radius >= g_world_config.chunk_size || local_z - radius >= g_world_config.chunk_size) {
+    return 0;
   }
 
-  // Free the trees array itself
-  if (node->chunk.trees) {
-    free(node->chunk.trees);
+  u8 trees = 0;
+  for (int cz = tree_grid_cell(local_z - radius, cell_size); cz <= tree_grid_cell(local_z + radius, cell_size); ++cz) {
+    for (int cx = tree_grid_cell(local_x - radius, cell_size); cx <= tree_grid_cell(local_x + radius, cell_size); ++cx) {
+      trees |= chunk->tree_grid[cz * TREE_GRID_DIM + cx];
+    }
   }
 
-  free(node);
+  return trees;
+}
+
+static inline chunk_map_node_t *cell_of(chunk_map_t *map, int x, int z) {
+  int mask = map->width - 1;
+  return &map->cells[((z & mask) << map->shift) | (x & mask)];
 }
 
-void init_chunk_map(chunk_map_t *map, usize num_buckets) {
+void init_chunk_map(chunk_map_t *map, int min_width) {
   if (!map) return;
 
-  map->num_buckets = num_buckets;
-  map->buckets = calloc(num_buckets, sizeof(chunk_map_node_t *));
+  map->shift = 0;
+  while ((1 << map->shift) < min_width) map->shift++;
+
+  map->width = 1 << map->shift;
+  map->cells = calloc((usize)map->width * map->width, sizeof(chunk_map_node_t));
+  if (!map->cells) map->width = 0;
 
   map->num_loaded_chunks = 0;
 }
@@ -35,111 +113,84 @@ void init_chunk_map(chunk_map_t *map, usize num_buckets) {
 void free_chunk_map(chunk_map_t *map) {
   if (!map) return;
 
-  for (usize i = 0; i < map->num_buckets; ++i) {
-    chunk_map_node_t *head = map->buckets[i];
-
-    while (head) {
-      chunk_map_node_t *next = head->next;
-      free_chunk_node(head);
-
-      head = next;
-    }
+  for (int i = 0; i < map->width * map->width; ++i) {
+    if (map->cells[i].loaded) free_chunk(&map->cells[i].chunk);
   }
 
-  free(map->buckets);
-  map->buckets = NULL;
+  free(map->cells);
+  map->cells = NULL;
+  map->width = 0;
   map->num_loaded_chunks = 0;
 }
 
 void insert_chunk(chunk_map_t *map, chunk_t *chunk) {
   if (!map || !chunk) return;
+  if (!map->cells) {
+    free_chunk(chunk);
+    return;
+  }
 
-  usize index = get_chunk_hash(chunk->x, chunk->z, map->num_buckets);
-
-  chunk_map_node_t *old_head = map->buckets[index];
-
-  // emplace new chunk at start of list, no reason to iterate to the end to add
-  chunk_map_node_t *head = malloc(sizeof(chunk_map_node_t));
-  head->chunk = *chunk;
-  head->loaded = true;
-  head->next = old_head;
+  chunk_map_node_t *cell = cell_of(map, chunk->x, chunk->z);
+  if (cell->loaded) {
+    free_chunk(&cell->chunk);
+    --map->num_loaded_chunks;
+  }
 
-  map->buckets[index] = head;
+  cell->chunk = *chunk;
+  cell->loaded = true;
   ++map->num_loaded_chunks;
 }
 
 void remove_chunk(chunk_map_t *map, int x, int z) {
-  if (!map) return;
+  chunk_map_node_t *cell = chunk_lookup(map, x, z);
+  if (!cell) return;
 
-  usize index = get_chunk_hash(x, z, map->num_buckets);
-  chunk_map_node_t *head = map->buckets[index], *prev = NULL;
-
-  while (head) {
-    if (head->chunk.x == x && head->chunk.z == z) {
-      if (prev == NULL) {
-        map->buckets[index] = head->next;
-      } else {
-        prev->next = head->next;
-      }
-
-      free_chunk_node(head);
-      --map->num_loaded_chunks;
-      return;
-    }
-    
-    prev = head;
-    head = head->next;
-  }
+  free_chunk(&cell->chunk);
+  cell->loaded = false;
+  --map->num_loaded_chunks;
 }
 
 void remove_chunk_if(chunk_map_t *map, query_func func, void *param, usize num_params) {
   if (!map) return;
 
-  for (usize i = 0; i < map->num_buckets; ++i) {
-    chunk_map_node_t *head = map->buckets[i], *prev = NULL;
+  for (int i = 0; i < map->width * map->width; ++i) {
+    chunk_map_node_t *cell = &map->cells[i];
 
-    while (head) {
-      chunk_map_node_t *next = head->next; // Store next before potential free
+    if (cell->loaded && func(&cell->chunk, param, num_params)) {
+      free_chunk(&cell->chunk);
+      cell->loaded = false;
+      --map->num_loaded_chunks;
+    }
+  }
+}
 
-      if (func(&head->chunk, param, num_params)) {
-        if (prev == NULL) {
-          map->buckets[i] = next;
-        } else {
-          prev->next = next;
-        }
+usize take_chunks_if(chunk_map_t *map, query_func func, void *param, usize num_params, chunk_t *out_buf, usize max_out) {
+  if (!map || !out_buf) return 0;
 
-        free_chunk_node(head);
-        --map->num_loaded_chunks;
+  usize taken = 0;
+  for (int i = 0; i < map->width * map->width && taken < max_out; ++i) {
+    chunk_map_node_t *cell = &map->cells[i];
 
-        // Continue with next node instead of returning
-        head = next;
-      } else {
-        prev = head;
-        head = next;
-      }
+    // the chunk's memory now belongs to the caller, only the cell is cleared
+    if (cell->loaded && func(&cell->chunk, param, num_params)) {
+      out_buf[taken++] = cell->chunk;
+      cell->loaded = false;
+      --map->num_loaded_chunks;
     }
   }
+
+  return taken;
 }
 
 chunk_map_node_t *chunk_lookup(chunk_map_t *map, int x, int z) {
-  if (!map) return NULL;
+  if (!map || !map->cells) return NULL;
 
-  usize index = get_chunk_hash(x, z, map->num_buckets);
-  chunk_map_node_t *head = map->buckets[index];
-
-  while (head) {
-    if (head->chunk.x == x && head->chunk.z == z)
-      return head;
-    
-    head = head->next;
-  }
-
-  return NULL;
+  chunk_map_node_t *cell = cell_of(map, x, z);
+  return cell->loaded && cell->chunk.x == x && cell->chunk.z == z ? cell : NULL;
 }
 
 bool is_chunk_loaded(chunk_map_t *map, int x, int z) {
-  chunk_map_node_t *node = chunk_lookup(map, x, z);
-  return node ? node->loaded : false;
+  return chunk_lookup(map, x, z) != NULL;
 }
 
 // used to get all chunks using query_chunk_map
@@ -156,14 +207,12 @@ void query_chunk_map(chunk_map_t *map, chunk_t **chunk_buf, usize *count, query_
   if (!map || !chunk_buf || !count) return;
 
   *count = 0;
-  for (usize i = 0; i < map->num_buckets; ++i) {
-    chunk_map_node_t *node = map->buckets[i];
-    while (node != NULL) {
-      if (node->loaded && func(&node->chunk, NULL, 0)) {
-        chunk_buf[*count] = &node->chunk;
-        (*count)++;
-      }
-      node = node->next;
+  for (int i = 0; i < map->width * map->width; ++i) {
+    chunk_map_node_t *cell = &map->cells[i];
+
+    if (cell->loaded && func(&cell->chunk, NULL, 0)) {
+      chunk_buf[*count] = &cell->chunk;
+      (*count)++;
     }
   }
-}
\ No newline at end of file
+}
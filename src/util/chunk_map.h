@@ -1,42 +1,180 @@
 #ifndef __CHUNK_MAP_H__
 #define __CHUNK_MAP_H__
 
+#include <math.h>
+
 #include <shader-works/primitives.h>
+#include <shader-works/maths.h>
+
+#include "chunk_arena.h"
+#include "config.h"
+#include "mesh.h"
+
+// hash2 lies in (-1, 1], so the tree count mapped onto [0, 7] never exceeds 7
+#define MAX_TREES_PER_CHUNK 7
+
+// Cells per side of the per-chunk tree grid, each cell is a bitmask over the chunk's trees
+#define TREE_GRID_DIM 4
+
+// Range tree_instance_t.scale is quantized over
+#define TREE_MIN_SCALE 0.8f
+#define TREE_MAX_SCALE 1.25f
+
+// Scales across that range every archetype is baked at, an instance draws the nearest one
+#define TREE_SCALE_STEPS 4
+
+// Sprite views per tree impostor and their resolution in texels
+#define IMPOSTOR_VIEWS 4
+#define IMPOSTOR_WIDTH 16
+#define IMPOSTOR_HEIGHT 32
+
+// Camera facing stand-in for a distant tree, built by generate_tree_impostor
+typedef struct {
+  u32 *sprites;                   // IMPOSTOR_VIEWS sprites, row 0 at the bottom of the tree
+  model_t views[IMPOSTOR_VIEWS];  // silhouette quads per sprite, drawn through billboard_vs
+  float half_width, bottom, height;
+} tree_impostor_t;
+
+// Shared tree mesh from the world's tree library, built around a base at the origin
+typedef struct {
+  indexed_mesh_t mesh;        // shared vertex rings, read by the shadow and impostor bakers
+  float3 *face_normals;       // one per triangle of mesh
+  model_t models[TREE_SCALE_STEPS];   // mesh as a triangle list at each baked scale, sharing
+                                      // face_normals. Drawn as is, turned by model_t.transform
+  tree_impostor_t impostor;
+  float3 aabb_min, aabb_max;  // bounds relative to the base
+  float radius;               // trunk base radius
+} tree_archetype_t;
+
+// One placed tree, everything else comes from its archetype. The turn and scale fill what was
+// padding, so an instance is still 16 bytes
+typedef struct {
+  float3 position;    // base of the trunk
+  u16 archetype;      // index into the tree library
+  u8 yaw;             // turn about the trunk in 1/256ths of a circle
+  u8 scale;           // TREE_MIN_SCALE at 0 up to TREE_MAX_SCALE at 255, drawn at the nearest baked step
+} tree_instance_t;
+
+// Baked scale an instance is drawn at, the nearest of the TREE_SCALE_STEPS to its scale byte
+static inline usize tree_instance_scale_step(const tree_instance_t *instance) {
+  return ((usize)instance->scale * (TREE_SCALE_STEPS - 1) + 127) / 255;
+}
+
+static inline float tree_scale_step_scale(usize step) {
+  return TREE_MIN_SCALE + (TREE_MAX_SCALE - TREE_MIN_SCALE) * ((float)step / (float)(TREE_SCALE_STEPS - 1));
+}
 
-#define CHUNK_MAP_NUM_BUCKETS 9
+// Turn of an instance as the yaw of the model_t.transform its mesh is drawn with
+static inline float tree_instance_yaw(const tree_instance_t *instance) {
+  return (float)instance->yaw * (2.0f * PI / 256.0f);
+}
 
+// An instance's placement decoded once, archetype space points are scaled, turned and moved to the
+// base. The turn is the basis shader-works gives a transform of that yaw, so points placed here land
+// where render_model draws the mesh's vertices (checked by tests/test_tree_transform.c)
+typedef struct {
+  float3 position;
+  float3 right, forward;    // where the archetype's x and z axes point
+  float scale;
+} tree_transform_t;
+
+static inline tree_transform_t tree_instance_transform(const tree_instance_t *instance) {
+  transform_t turn = { 0 };
+  turn.yaw = tree_instance_yaw(instance);
+  float3 right, up, forward;
+  transform_get_basis_vectors(&turn, &right, &up, &forward);
+
+  return (tree_transform_t){
+    .position = instance->position,
+    .right = right,
+    .forward = forward,
+    .scale = tree_scale_step_scale(tree_instance_scale_step(instance))
+  };
+}
+
+// Turns an archetype space direction, normals keep their length since the scale is uniform
+static inline float3 tree_transform_direction(const tree_transform_t *transform, float3 d) {
+  return make_float3(transform->right.x * d.x + transform->forward.x * d.z, d.y, transform->right.z * d.x + transform->forward.z * d.z);
+}
+
+// Undoes tree_transform_direction, takes world directions into archetype space
+static inline float3 tree_untransform_direction(const tree_transform_t *transform, float3 d) {
+  return make_float3(transform->right.x * d.x + transform->right.z * d.z, d.y, transform->forward.x * d.x + transform->forward.z * d.z);
+}
+
+static inline float3 tree_transform_point(const tree_transform_t *transform, float3 p) {
+  return float3_add(transform->position, float3_scale(tree_transform_direction(transform, p), transform->scale));
+}
+
+// Everything a chunk points to lives in its arena, so releasing the arena frees the whole chunk
 typedef struct {
   int x, z;
-  model_t ground_plane;
-  model_t *trees;
+  chunk_arena_t *arena;
+  float *heights;   // (chunk_size + 1)^2 terrain heights at 1 unit spacing, row major in z
+  u32 *albedo;      // albedo_size^2 baked ground material, row major in z
+  int albedo_size;
+
+  u8 *shadow_mask;  // shadow_size^2 tree shadow coverage, built on the main thread by update_shadow_masks
+  int shadow_size;
+  float3 shadow_sun;      // sun direction the mask was built for
+  u16 shadow_neighbours;  // loaded 3x3 neighbourhood the mask was built from
+  model_t ground_lods[MAX_GROUND_LODS];   // level i has 2^i unit segments, ground_lod_levels are built
+  float3 aabb_min, aabb_max;        // world space bounds of every ground LOD, skirts and tree
+  tree_instance_t *tree_instances;  // only trees that were actually placed
   usize num_trees;
+  u8 tree_grid[TREE_GRID_DIM * TREE_GRID_DIM];  // bit i set when tree i's bounds overlap the cell
 } chunk_t;
 
 typedef struct chunk_map_node_t {
   chunk_t chunk;
-  struct chunk_map_node_t *next;
   bool loaded;
 } chunk_map_node_t;
 
+// Toroidal grid of width * width cells, chunk (x, z) lives in cell (x mod width, z mod width).
+// Resident chunks always form a window at most width chunks wide around the player, so no two
+// of them share a cell and neighbours are found without hashing or pointer chasing. width is a
+// power of two so the wrap is a mask, which also handles negative coordinates
 typedef struct {
-  chunk_map_node_t **buckets;
-  usize num_buckets, num_loaded_chunks;
+  chunk_map_node_t *cells;
+  int width, shift;
+  usize num_loaded_chunks;
 } chunk_map_t;
 
 // return true to include chunk in final chunk buffer
 typedef bool (*query_func)(chunk_t *chunk, void *param, usize num_params);
 
-void init_chunk_map(chunk_map_t *map, usize num_buckets);
+// Release the arena of a chunk that is not (or no longer) in a map
+void free_chunk(chunk_t *chunk);
+
+// Bytes of memory held by a chunk
+usize chunk_memory_size(const chunk_t *chunk);
+
+// Fill tree_grid from the tree bounds, call once the instance table is complete
+void build_tree_grid(chunk_t *chunk);
+
+// Bitmask of the trees whose bounds may overlap the square of half size radius around (x, z)
+u8 trees_near(const chunk_t *chunk, float x, float z, float radius);
+
+// min_width is rounded up to a power of two
+void init_chunk_map(chunk_map_t *map, int min_width);
 void free_chunk_map(chunk_map_t *map);
 
+// Takes ownership of chunk, a different chunk already in its cell is freed
 void insert_chunk(chunk_map_t *map, chunk_t *chunk);
 void remove_chunk(chunk_map_t *map, int x, int z);
 void remove_chunk_if(chunk_map_t *map, query_func, void *param, usize num_params);
 
+// Like remove_chunk_if, but hands the chunks to the caller instead of freeing them
+// Returns the number of chunks written to out_buf, stops early once max_out is reached
+usize take_chunks_if(chunk_map_t *map, query_func, void *param, usize num_params, chunk_t *out_buf, usize max_out);
+
 chunk_map_node_t *chunk_lookup(chunk_map_t *map, int x, int z);
 bool is_chunk_loaded(chunk_map_t *map, int x, int z);
 
 void get_all_chunks(chunk_map_t *map, chunk_t **chunk_buf, usize *count);
 void query_chunk_map(chunk_map_t *map, chunk_t **chunk_buf, usize *count, query_func func);
 
+// Time lookups in the grid against the chained hash map it replaced, found in chunk_map_bench.c
+void run_chunk_map_benchmark(usize iterations);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "chunk_map.h"
+#include "config.h"
+#include "perf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+// Microbenchmark of the toroidal chunk grid against the chained hash map it replaced. Both maps
+// hold the same resident window and answer the lookups the ground shader and shadow baker make:
+// the chunk under a point and the 3x3 neighbourhood of a chunk.
+
+#define LEGACY_NUM_BUCKETS 9
+
+typedef struct legacy_node_t {
+  chunk_t chunk;
+  struct legacy_node_t *next;
+} legacy_node_t;
+
+static inline usize legacy_hash(int x, int z) {
+  return ((x * 73856093) ^ (z * 19349663)) % LEGACY_NUM_BUCKETS;
+}
+
+static void legacy_insert(legacy_node_t **buckets, int x, int z) {
+  legacy_node_t *node = calloc(1, sizeof(legacy_node_t));
+  if (!node) return;
+
+  usize index = legacy_hash(x, z);
+  node->chunk.x = x;
+  node->chunk.z = z;
+  node->next = buckets[index];
+  buckets[index] = node;
+}
+
+static chunk_t *legacy_lookup(legacy_node_t **buckets, int x, int z) {
+  for (legacy_node_t *node = buckets[legacy_hash(x, z)]; node; node = node->next) {
+    if (node->chunk.x == x && node->chunk.z == z) return &node->chunk;
+  }
+  return NULL;
+}
+
+static void legacy_free(legacy_node_t **buckets) {
+  for (usize i = 0; i < LEGACY_NUM_BUCKETS; ++i) {
+    while (buckets[i]) {
+      legacy_node_t *next = buckets[i]->next;
+      free(buckets[i]);
+      buckets[i] = next;
+    }
+  }
+}
+
+static inline int floor_div(int a, int b) {
+  int q = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// xorshift, the same sequence drives both maps
+static inline u32 next_random(u32 *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+void run_chunk_map_benchmark(usize iterations) {
+  int width = g_world_config.resident_width;
+  int radius = width / 2;
+  int chunk_size = g_world_config.chunk_size;
+
+  // an off-origin window so negative coordinates and wrapping are exercised
+  int anchor_x = -37, anchor_z = 91;
+
+  chunk_map_t grid;
+  init_chunk_map(&grid, width);
+  legacy_node_t *buckets[LEGACY_NUM_BUCKETS] = {0};
+
+  for (int dz = -radius; dz <= radius; ++dz) {
+    for (int dx = -radius; dx <= radius; ++dx) {
+      chunk_t chunk = { .x = anchor_x + dx, .z = anchor_z + dz };
+      insert_chunk(&grid, &chunk);
+      legacy_insert(buckets, chunk.x, chunk.z);
+    }
+  }
+
+  int span = width * chunk_size;
+  int origin_x = (anchor_x - radius) * chunk_size;
+  int origin_z = (anchor_z - radius) * chunk_size;
+
+  for (int map = 0; map < 2; ++map) {
+    u32 state = 0x9e3779b9u;
+    usize found = 0;
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (usize i = 0; i < iterations; ++i) {
+      int chunk_x = floor_div(origin_x + (int)(next_random(&state) % (u32)span), chunk_size);
+      int chunk_z = floor_div(origin_z + (int)(next_random(&state) % (u32)span), chunk_size);
+
+      found += map == 0 ? (chunk_lookup(&grid, chunk_x, chunk_z) != NULL) : (legacy_lookup(buckets, chunk_x, chunk_z) != NULL);
+    }
+    float point_ms = perf_elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    start = SDL_GetPerformanceCounter();
+    for (usize i = 0; i < iterations / 9; ++i) {
+      int chunk_x = anchor_x + (int)(next_random(&state) % (u32)width) - radius;
+      int chunk_z = anchor_z + (int)(next_random(&state) % (u32)width) - radius;
+
+      for (int dz = -1; dz <= 1; ++dz) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          found += map == 0 ? (chunk_lookup(&grid, chunk_x + dx, chunk_z + dz) != NULL) : (legacy_lookup(buckets, chunk_x + dx, chunk_z + dz) != NULL);
+        }
+      }
+    }
+    float neighbour_ms = perf_elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    printf("  %-12s point lookup %.2f ns, 3x3 neighbourhood %.2f ns (%zu hits)\n", map == 0 ? "grid:" : "chained map:",
+           point_ms * 1e6f / (float)iterations, neighbour_ms * 1e6f / (float)(iterations / 9), found);
+  }
+
+  free_chunk_map(&grid);
+  legacy_free(buckets);
+}
@@ -0,0 +1,280 @@
+#include "chunk_store.h"
+#include "config.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+#define CHUNK_STORE_MAGIC 0x4b444e54u   // "TNDK"
+#define CHUNK_STORE_FORMAT 2
+
+// the header gets its own page and every slot is page aligned, slots past the end of a file are
+// left as holes until written
+#define REGION_PAGE 4096
+#define SLOT_PART_ALIGNMENT 64
+
+// FNV-1a, applied to 32 bit words
+#define CHECKSUM_BASIS 2166136261u
+#define CHECKSUM_PRIME 16777619u
+
+typedef struct {
+  u32 magic, format, generator_version;
+  i32 seed, chunk_size, albedo_size, archetype_variants;
+  i32 region_x, region_z;
+  u32 slot_size;
+} region_header_t;
+
+// Start of every slot. checksum covers the rest of the header and every part, so a slot that was
+// never written or only partly written is a miss
+typedef struct {
+  u32 checksum;
+  i32 x, z;
+  u32 num_trees;
+} slot_header_t;
+
+// Byte offsets of the parts of a slot
+typedef struct {
+  usize heights, albedo, trees, size;
+} slot_layout_t;
+
+typedef struct {
+  int x, z;
+  SDL_IOStream *io;   // open until free_chunk_store, NULL when the file could not be opened
+} region_t;
+
+typedef struct {
+  bool enabled;
+  char directory[512];
+  slot_layout_t layout;
+  usize heights_size, albedo_bytes;
+  region_header_t key;    // what every region header must hold, region_x/z aside
+
+  // streams are shared by the workers, lock covers them and the region list. Checksums are
+  // computed outside it so only file IO is serialized
+  region_t *regions;
+  usize num_regions, capacity;
+  SDL_Mutex *lock;
+
+  SDL_AtomicInt hits, misses;
+} chunk_store_t;
+
+static chunk_store_t store = {0};
+
+static inline usize align_up(usize value, usize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static inline int floor_div(int a, int b) {
+  int q = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+void init_chunk_store(const char *directory) {
+  if (store.enabled || !directory || directory[0] == '\0') return;
+
+  if (!SDL_CreateDirectory(directory)) {
+    printf("Chunk store disabled, cannot create %s: %s\n", directory, SDL_GetError());
+    return;
+  }
+
+  usize stride = (usize)g_world_config.chunk_size + 1;
+  usize albedo_size = (usize)g_world_config.chunk_size * g_world_config.ground_texels_per_unit;
+
+  store = (chunk_store_t){ .enabled = true, .lock = SDL_CreateMutex() };
+  snprintf(store.directory, sizeof(store.directory), "%s", directory);
+  store.heights_size = stride * stride * sizeof(float);
+  store.albedo_bytes = albedo_size * albedo_size * sizeof(u32);
+
+  store.layout.heights = align_up(sizeof(slot_header_t), SLOT_PART_ALIGNMENT);
+  store.layout.albedo = align_up(store.layout.heights + store.heights_size, SLOT_PART_ALIGNMENT);
+  store.layout.trees = align_up(store.layout.albedo + store.albedo_bytes, SLOT_PART_ALIGNMENT);
+  store.layout.size = align_up(store.layout.trees + MAX_TREES_PER_CHUNK * sizeof(tree_instance_t), REGION_PAGE);
+
+  memset(&store.key, 0, sizeof(store.key));
+  store.key.magic = CHUNK_STORE_MAGIC;
+  store.key.format = CHUNK_STORE_FORMAT;
+  store.key.generator_version = CHUNK_GENERATOR_VERSION;
+  store.key.seed = g_world_config.seed;
+  store.key.chunk_size = g_world_config.chunk_size;
+  store.key.albedo_size = (i32)albedo_size;
+  store.key.archetype_variants = g_world_config.tree_archetype_variants;
+  store.key.slot_size = (u32)store.layout.size;
+}
+
+void free_chunk_store(void) {
+  if (!store.enabled) return;
+
+  for (usize i = 0; i < store.num_regions; ++i) {
+    if (store.regions[i].io) SDL_CloseIO(store.regions[i].io);
+  }
+
+  free(store.regions);
+  SDL_DestroyMutex(store.lock);
+  store = (chunk_store_t){0};
+}
+
+static bool read_at(SDL_IOStream *io, usize offset, void *data, usize size) {
+  return SDL_SeekIO(io, (Sint64)offset, SDL_IO_SEEK_SET) == (Sint64)offset && SDL_ReadIO(io, data, size) == size;
+}
+
+static bool write_at(SDL_IOStream *io, usize offset, const void *data, usize size) {
+  return SDL_SeekIO(io, (Sint64)offset, SDL_IO_SEEK_SET) == (Sint64)offset && SDL_WriteIO(io, data, size) == size;
+}
+
+// Every part is a whole number of words, trees included since tree_instance_t has no padding
+static u32 checksum_words(u32 hash, const void *data, usize size) {
+  const u8 *bytes = data;
+  for (usize i = 0; i + sizeof(u32) <= size; i += sizeof(u32)) {
+    u32 word;
+    memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * CHECKSUM_PRIME;
+  }
+  return hash;
+}
+
+static u32 slot_checksum(const slot_header_t *header, const float *heights, const u32 *albedo, const tree_instance_t *trees) {
+  u32 hash = checksum_words(CHECKSUM_BASIS, &header->x, sizeof(*header) - offsetof(slot_header_t, x));
+  hash = checksum_words(hash, heights, store.heights_size);
+  if (albedo) hash = checksum_words(hash, albedo, store.albedo_bytes);
+  return checksum_words(hash, trees, header->num_trees * sizeof(tree_instance_t));
+}
+
+// Open region file (rx, rz), creating or resetting it when its header does not match. Caller holds the lock
+static SDL_IOStream *open_region(int rx, int rz) {
+  char path[600];
+  snprintf(path, sizeof(path), "%s/s%d_r%d_%d.bin", store.directory, store.key.seed, rx, rz);
+
+  region_header_t expected = store.key;
+  expected.region_x = rx;
+  expected.region_z = rz;
+
+  SDL_IOStream *io = SDL_IOFromFile(path, "r+b");
+  if (io) {
+    region_header_t header;
+    if (read_at(io, 0, &header, sizeof(header)) && memcmp(&header, &expected, sizeof(header)) == 0) return io;
+    SDL_CloseIO(io);
+  }
+
+  // missing, a stale generator or different settings, every slot is dropped
+  io = SDL_IOFromFile(path, "w+b");
+  if (!io) return NULL;
+
+  if (!write_at(io, 0, &expected, sizeof(expected)) || !SDL_FlushIO(io)) {
+    SDL_CloseIO(io);
+    return NULL;
+  }
+  return io;
+}
+
+// Stream of chunk (x, z)'s region and the slot's offset in it, NULL when the region is unavailable.
+// Caller holds the lock
+static SDL_IOStream *find_slot(int x, int z, usize *offset) {
+  int rx = floor_div(x, REGION_DIM);
+  int rz = floor_div(z, REGION_DIM);
+
+  region_t *region = NULL;
+  for (usize i = 0; i < store.num_regions; ++i) {
+    if (store.regions[i].x == rx && store.regions[i].z == rz) {
+      region = &store.regions[i];
+      break;
+    }
+  }
+
+  if (!region) {
+    if (store.num_regions == store.capacity) {
+      usize capacity = store.capacity ? store.capacity * 2 : 16;
+      region_t *regions = realloc(store.regions, capacity * sizeof(region_t));
+      if (!regions) return NULL;
+
+      store.regions = regions;
+      store.capacity = capacity;
+    }
+
+    // failed opens are remembered too, so a broken file is not retried for every chunk
+    region = &store.regions[store.num_regions++];
+    *region = (region_t){ .x = rx, .z = rz, .io = open_region(rx, rz) };
+  }
+
+  int slot = (z - rz * REGION_DIM) * REGION_DIM + (x - rx * REGION_DIM);
+  *offset = REGION_PAGE + (usize)slot * store.layout.size;
+  return region->io;
+}
+
+bool chunk_store_load(chunk_t *chunk, int x, int z) {
+  if (!store.enabled || !chunk || !chunk->arena) return false;
+
+  // the parts are read straight into the chunk's arena, a miss rewinds it to where it was
+  usize arena_mark = chunk->arena->used;
+  float *heights = NULL;
+  u32 *albedo = NULL;
+  tree_instance_t *trees = NULL;
+  slot_header_t header = {0};
+
+  SDL_LockMutex(store.lock);
+
+  usize offset = 0;
+  SDL_IOStream *io = find_slot(x, z, &offset);
+  bool hit = io && read_at(io, offset, &header, sizeof(header)) &&
+             header.x == x && header.z == z && header.num_trees <= MAX_TREES_PER_CHUNK;
+
+  if (hit) {
+    heights = chunk_arena_alloc(chunk->arena, store.heights_size);
+    if (store.albedo_bytes > 0) albedo = chunk_arena_alloc(chunk->arena, store.albedo_bytes);
+    if (header.num_trees > 0) trees = chunk_arena_alloc(chunk->arena, header.num_trees * sizeof(tree_instance_t));
+
+    hit = heights && (albedo || store.albedo_bytes == 0) && (trees || header.num_trees == 0) &&
+          read_at(io, offset + store.layout.heights, heights, store.heights_size) &&
+          (!albedo || read_at(io, offset + store.layout.albedo, albedo, store.albedo_bytes)) &&
+          (!trees || read_at(io, offset + store.layout.trees, trees, header.num_trees * sizeof(tree_instance_t)));
+  }
+
+  SDL_UnlockMutex(store.lock);
+
+  hit = hit && slot_checksum(&header, heights, albedo, trees) == header.checksum;
+  if (!hit) {
+    chunk->arena->used = arena_mark;
+    SDL_AddAtomicInt(&store.misses, 1);
+    return false;
+  }
+
+  chunk->heights = heights;
+  chunk->albedo_size = albedo ? store.key.albedo_size : 0;
+  chunk->albedo = albedo;
+  chunk->tree_instances = trees;
+  chunk->num_trees = header.num_trees;
+  SDL_AddAtomicInt(&store.hits, 1);
+  return true;
+}
+
+void chunk_store_save(const chunk_t *chunk) {
+  if (!store.enabled || !chunk || !chunk->heights || chunk->num_trees > MAX_TREES_PER_CHUNK) return;
+  if (chunk->albedo_size != store.key.albedo_size || (store.key.albedo_size > 0 && !chunk->albedo)) return;
+
+  // the checksum is taken from the chunk's own data, nothing is copied
+  slot_header_t header = { .x = chunk->x, .z = chunk->z, .num_trees = (u32)chunk->num_trees };
+  header.checksum = slot_checksum(&header, chunk->heights, chunk->albedo, chunk->tree_instances);
+
+  SDL_LockMutex(store.lock);
+
+  // the header goes last, a write cut short leaves parts that don't match its checksum
+  usize offset = 0;
+  SDL_IOStream *io = find_slot(chunk->x, chunk->z, &offset);
+  if (io) {
+    bool written = write_at(io, offset + store.layout.heights, chunk->heights, store.heights_size) &&
+                   (!chunk->albedo || write_at(io, offset + store.layout.albedo, chunk->albedo, store.albedo_bytes)) &&
+                   (chunk->num_trees == 0 || write_at(io, offset + store.layout.trees, chunk->tree_instances, chunk->num_trees * sizeof(tree_instance_t)));
+    if (written) write_at(io, offset, &header, sizeof(header));
+    SDL_FlushIO(io);
+  }
+
+  SDL_UnlockMutex(store.lock);
+}
+
+bool chunk_store_stats(usize *hits, usize *misses) {
+  if (hits) *hits = (usize)SDL_GetAtomicInt(&store.hits);
+  if (misses) *misses = (usize)SDL_GetAtomicInt(&store.misses);
+  return store.enabled;
+}
@@ -0,0 +1,34 @@
+#ifndef __CHUNK_STORE_H__
+#define __CHUNK_STORE_H__
+
+#include "chunk_map.h"
+
+// Bump whenever terrain heights, the ground material or tree placement change, stored chunks
+// from older generators are then discarded instead of loaded
+#define CHUNK_GENERATOR_VERSION 2
+
+// Generated chunk data persisted across runs in region files of REGION_DIM^2 chunks, read and
+// written through SDL_IOStream. Loads read heights, the ground albedo and tree instances into the
+// chunk's arena, every slot carries a checksum so torn or stale slots are misses. Region files are
+// keyed by seed, chunk size, albedo size, tree archetype variants and CHUNK_GENERATOR_VERSION, a file
+// written with any other key is reset. Opt-in through world.chunk_store_dir. Safe to call from the
+// chunk workers.
+#define REGION_DIM 8
+
+// Open the store in directory, an empty path leaves it disabled
+void init_chunk_store(const char *directory);
+
+// Closes every region file
+void free_chunk_store(void);
+
+// Fill heights, albedo and tree_instances of chunk (x, z) from the store, chunk->arena must be set.
+// Returns false on a miss, the chunk is then left untouched
+bool chunk_store_load(chunk_t *chunk, int x, int z);
+
+// Persist a freshly generated chunk, chunks missing any of their data are skipped
+void chunk_store_save(const chunk_t *chunk);
+
+// Loads served from disk and loads that missed since init, false when the store is disabled
+bool chunk_store_stats(usize *hits, usize *misses);
+
+#endif
@@ -0,0 +1,26 @@
+#include "color.h"
+
+#include <stdio.h>
+
+#include <SDL3/SDL.h>
+
+bool check_color_format(void) {
+  const SDL_PixelFormatDetails *format = SDL_GetPixelFormatDetails(SDL_PIXELFORMAT_RGBA8888);
+  if (!format) {
+    printf("Failed to look up the RGBA8888 pixel format: %s\n", SDL_GetError());
+    return false;
+  }
+
+  bool compatible = format->bytes_per_pixel == sizeof(u32) &&
+                    format->Rmask == 0xffu << COLOR_R_SHIFT &&
+                    format->Gmask == 0xffu << COLOR_G_SHIFT &&
+                    format->Bmask == 0xffu << COLOR_B_SHIFT &&
+                    format->Amask == COLOR_A_MASK;
+
+  if (!compatible) {
+    printf("RGBA8888 masks %08x %08x %08x %08x don't match the packed color layout\n",
+           format->Rmask, format->Gmask, format->Bmask, format->Amask);
+  }
+
+  return compatible;
+}
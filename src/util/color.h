@@ -0,0 +1,63 @@
+#ifndef __COLOR_H__
+#define __COLOR_H__
+
+#include <shader-works/renderer.h>
+
+// Pixels are SDL_PIXELFORMAT_RGBA8888: red in the top byte, alpha in the bottom one. The layout is
+// fixed at compile time so shaders pack and unpack with shifts, check_color_format makes sure SDL
+// agrees before anything is drawn
+#define COLOR_R_SHIFT 24
+#define COLOR_G_SHIFT 16
+#define COLOR_B_SHIFT 8
+#define COLOR_A_SHIFT 0
+#define COLOR_A_MASK (0xffu << COLOR_A_SHIFT)
+
+// Factors and blend weights are 8 bit fixed point, COLOR_ONE leaves a color unchanged
+#define COLOR_ONE 256u
+
+// Two channels sit in 16 bit lanes of one word, so one multiply scales both. 255 * COLOR_ONE still
+// fits in a lane, nothing carries into the next one
+#define COLOR_LANE_MASK 0x00ff00ffu
+
+static inline u32 color_pack(u8 r, u8 g, u8 b) {
+  return ((u32)r << COLOR_R_SHIFT) | ((u32)g << COLOR_G_SHIFT) | ((u32)b << COLOR_B_SHIFT) | COLOR_A_MASK;
+}
+
+static inline void color_unpack(u32 color, u8 *r, u8 *g, u8 *b) {
+  *r = (u8)(color >> COLOR_R_SHIFT);
+  *g = (u8)(color >> COLOR_G_SHIFT);
+  *b = (u8)(color >> COLOR_B_SHIFT);
+}
+
+// Fixed point factor of a float in [0, 1], clamped
+static inline u32 color_factor(float t) {
+  float f = t * (float)COLOR_ONE;
+  f = f < 0.0f ? 0.0f : f;
+  return (u32)(f > (float)COLOR_ONE ? (float)COLOR_ONE : f);
+}
+
+// Every color channel times factor / COLOR_ONE rounded down, alpha is kept. factor <= COLOR_ONE
+static inline u32 color_scale(u32 color, u32 factor) {
+  u32 lo = (((color & COLOR_LANE_MASK) * factor) >> 8) & COLOR_LANE_MASK;
+  u32 hi = (((color >> 8) & COLOR_LANE_MASK) * factor) & ~COLOR_LANE_MASK;
+  return ((lo | hi) & ~COLOR_A_MASK) | (color & COLOR_A_MASK);
+}
+
+// a blended toward b by t / COLOR_ONE, all four channels. t <= COLOR_ONE
+static inline u32 color_lerp(u32 a, u32 b, u32 t) {
+  u32 keep = COLOR_ONE - t;
+  u32 lo = (((a & COLOR_LANE_MASK) * keep + (b & COLOR_LANE_MASK) * t) >> 8) & COLOR_LANE_MASK;
+  u32 hi = (((a >> 8) & COLOR_LANE_MASK) * keep + ((b >> 8) & COLOR_LANE_MASK) * t) & ~COLOR_LANE_MASK;
+  return lo | hi;
+}
+
+// Four pixels at a time for the post pass, a plain loop over fixed size arrays that compiles to
+// one vector operation
+static inline void color_lerp_x4(u32 out[4], const u32 a[4], const u32 b[4], const u32 t[4]) {
+  for (int i = 0; i < 4; ++i) out[i] = color_lerp(a[i], b[i], t[i]);
+}
+
+// false when SDL's RGBA8888 does not have the layout above, call once at startup
+bool check_color_format(void);
+
+#endif
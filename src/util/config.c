@@ -9,6 +9,9 @@ cJSON *g_config = NULL;
 // Global world config
 world_config_t g_world_config = {0};
 
+// Global profiler config
+profiler_config_t g_profiler_config = {0};
+
 // Default values
 #define DEFAULT_TITLE "Tundra"
 #define DEFAULT_WIDTH 200
@@ -19,7 +22,25 @@ world_config_t g_world_config = {0};
 #define DEFAULT_WORLD_SEED 2
 #define DEFAULT_CHUNK_SIZE 32
 #define DEFAULT_GROUND_SEGMENTS_PER_CHUNK 4
+#define DEFAULT_GROUND_LOD_DISTANCE 40.0f
 #define DEFAULT_CHUNK_LOAD_RADIUS 1
+#define DEFAULT_CHUNK_WORKER_THREADS 0
+#define DEFAULT_CHUNK_HYSTERESIS 4.0f
+#define DEFAULT_CHUNK_CACHE_MB 64
+#define DEFAULT_GROUND_TEXELS_PER_UNIT 8
+#define DEFAULT_TREE_SHADOW_TEXELS_PER_UNIT 2
+#define DEFAULT_TREE_IMPOSTOR_DISTANCE 32.0f
+#define DEFAULT_TREE_ARCHETYPE_VARIANTS 4
+#define DEFAULT_CHUNK_STORE_DIR ""
+#define DEFAULT_HIZ_OCCLUDER_CHUNKS 2
+#define DEFAULT_HIZ_VERIFY false
+#define DEFAULT_DEFERRED_SHADING false
+#define DEFAULT_SNOW_PARTICLES 300
+#define DEFAULT_PIPELINED_RENDERING false
+
+// Default profiler values
+#define DEFAULT_PROFILER_HISTORY_FRAMES 1024
+#define DEFAULT_PROFILER_FRAME_BUDGET_MS 33.3f
 
 int load_config(unsigned int *width, unsigned int *height, unsigned int *scale, char *title, size_t title_size) {
   FILE *config_file = fopen("config.json", "r");
@@ -90,7 +111,21 @@ int load_world_config(void) {
   g_world_config.seed = DEFAULT_WORLD_SEED;
   g_world_config.chunk_size = DEFAULT_CHUNK_SIZE;
   g_world_config.ground_segments_per_chunk = DEFAULT_GROUND_SEGMENTS_PER_CHUNK;
+  g_world_config.ground_lod_distance = DEFAULT_GROUND_LOD_DISTANCE;
   g_world_config.chunk_load_radius = DEFAULT_CHUNK_LOAD_RADIUS;
+  g_world_config.chunk_worker_threads = DEFAULT_CHUNK_WORKER_THREADS;
+  g_world_config.chunk_hysteresis = DEFAULT_CHUNK_HYSTERESIS;
+  g_world_config.chunk_cache_mb = DEFAULT_CHUNK_CACHE_MB;
+  g_world_config.ground_texels_per_unit = DEFAULT_GROUND_TEXELS_PER_UNIT;
+  g_world_config.tree_shadow_texels_per_unit = DEFAULT_TREE_SHADOW_TEXELS_PER_UNIT;
+  g_world_config.tree_impostor_distance = DEFAULT_TREE_IMPOSTOR_DISTANCE;
+  g_world_config.tree_archetype_variants = DEFAULT_TREE_ARCHETYPE_VARIANTS;
+  strncpy(g_world_config.chunk_store_dir, DEFAULT_CHUNK_STORE_DIR, sizeof(g_world_config.chunk_store_dir) - 1);
+  g_world_config.hiz_occluder_chunks = DEFAULT_HIZ_OCCLUDER_CHUNKS;
+  g_world_config.hiz_verify = DEFAULT_HIZ_VERIFY;
+  g_world_config.deferred_shading = DEFAULT_DEFERRED_SHADING;
+  g_world_config.snow_particles = DEFAULT_SNOW_PARTICLES;
+  g_world_config.pipelined_rendering = DEFAULT_PIPELINED_RENDERING;
 
   if (!g_config) {
     printf("Config not loaded, using default world settings\n");
@@ -103,12 +138,43 @@ int load_world_config(void) {
     cJSON *seed = cJSON_GetObjectItem(world, "seed");
     cJSON *chunk_size = cJSON_GetObjectItem(world, "chunk_size");
     cJSON *ground_segments = cJSON_GetObjectItem(world, "ground_segments_per_chunk");
+    cJSON *lod_distance = cJSON_GetObjectItem(world, "ground_lod_distance");
     cJSON *load_radius = cJSON_GetObjectItem(world, "chunk_load_radius");
+    cJSON *worker_threads = cJSON_GetObjectItem(world, "chunk_worker_threads");
+    cJSON *hysteresis = cJSON_GetObjectItem(world, "chunk_hysteresis");
+    cJSON *cache_mb = cJSON_GetObjectItem(world, "chunk_cache_mb");
+    cJSON *texels = cJSON_GetObjectItem(world, "ground_texels_per_unit");
+    cJSON *shadow_texels = cJSON_GetObjectItem(world, "tree_shadow_texels_per_unit");
+    cJSON *impostor_distance = cJSON_GetObjectItem(world, "tree_impostor_distance");
+    cJSON *archetype_variants = cJSON_GetObjectItem(world, "tree_archetype_variants");
+    cJSON *store_dir = cJSON_GetObjectItem(world, "chunk_store_dir");
+    cJSON *occluder_chunks = cJSON_GetObjectItem(world, "hiz_occluder_chunks");
+    cJSON *hiz_verify = cJSON_GetObjectItem(world, "hiz_verify");
+    cJSON *deferred = cJSON_GetObjectItem(world, "deferred_shading");
+    cJSON *snow_particles = cJSON_GetObjectItem(world, "snow_particles");
+    cJSON *pipelined = cJSON_GetObjectItem(world, "pipelined_rendering");
 
     if (cJSON_IsNumber(seed)) g_world_config.seed = seed->valueint;
     if (cJSON_IsNumber(chunk_size)) g_world_config.chunk_size = chunk_size->valueint;
     if (cJSON_IsNumber(ground_segments)) g_world_config.ground_segments_per_chunk = ground_segments->valueint;
+    if (cJSON_IsNumber(lod_distance) && lod_distance->valuedouble > 0.0) g_world_config.ground_lod_distance = (float)lod_distance->valuedouble;
     if (cJSON_IsNumber(load_radius)) g_world_config.chunk_load_radius = load_radius->valueint;
+    if (cJSON_IsNumber(worker_threads) && worker_threads->valueint >= 0) g_world_config.chunk_worker_threads = worker_threads->valueint;
+    if (cJSON_IsNumber(hysteresis) && hysteresis->valuedouble >= 0.0) g_world_config.chunk_hysteresis = (float)hysteresis->valuedouble;
+    if (cJSON_IsNumber(cache_mb) && cache_mb->valueint >= 0) g_world_config.chunk_cache_mb = cache_mb->valueint;
+    if (cJSON_IsNumber(texels) && texels->valueint >= 0) g_world_config.ground_texels_per_unit = texels->valueint;
+    if (cJSON_IsNumber(shadow_texels) && shadow_texels->valueint >= 0) g_world_config.tree_shadow_texels_per_unit = shadow_texels->valueint;
+    if (cJSON_IsNumber(impostor_distance) && impostor_distance->valuedouble >= 0.0) g_world_config.tree_impostor_distance = (float)impostor_distance->valuedouble;
+    if (cJSON_IsNumber(archetype_variants) && archetype_variants->valueint > 0) g_world_config.tree_archetype_variants = archetype_variants->valueint;
+    if (cJSON_IsString(store_dir)) {
+      strncpy(g_world_config.chunk_store_dir, store_dir->valuestring, sizeof(g_world_config.chunk_store_dir) - 1);
+      g_world_config.chunk_store_dir[sizeof(g_world_config.chunk_store_dir) - 1] = '\0';
+    }
+    if (cJSON_IsNumber(occluder_chunks) && occluder_chunks->valueint >= 0) g_world_config.hiz_occluder_chunks = occluder_chunks->valueint;
+    if (cJSON_IsBool(hiz_verify)) g_world_config.hiz_verify = cJSON_IsTrue(hiz_verify);
+    if (cJSON_IsBool(deferred)) g_world_config.deferred_shading = cJSON_IsTrue(deferred);
+    if (cJSON_IsNumber(snow_particles) && snow_particles->valueint >= 0) g_world_config.snow_particles = snow_particles->valueint;
+    if (cJSON_IsBool(pipelined)) g_world_config.pipelined_rendering = cJSON_IsTrue(pipelined);
 
     printf("Loaded world config: seed=%d, chunk_size=%d, segments=%d, load_radius=%d\n",
            g_world_config.seed, g_world_config.chunk_size,
@@ -119,7 +185,36 @@ calculate_derived:
   // Calculate derived values
   g_world_config.half_chunk_size = g_world_config.chunk_size / 2;
   g_world_config.ground_segment_size = (float)g_world_config.chunk_size / (float)g_world_config.ground_segments_per_chunk;
-  g_world_config.max_chunks = (g_world_config.chunk_load_radius * 2 + 1) * (g_world_config.chunk_load_radius * 2 + 1);
+
+  // halve the ground resolution per level until ground_segments_per_chunk segments per side remain
+  g_world_config.ground_lod_levels = 1;
+  while (g_world_config.ground_lod_levels < MAX_GROUND_LODS) {
+    int segment = 1 << g_world_config.ground_lod_levels;
+    if (g_world_config.chunk_size % segment != 0 || g_world_config.chunk_size / segment < g_world_config.ground_segments_per_chunk) break;
+    g_world_config.ground_lod_levels++;
+  }
+
+  // chunks are kept one ring past the load radius before being evicted
+  g_world_config.resident_width = (g_world_config.chunk_load_radius + 1) * 2 + 1;
+  g_world_config.max_chunks = g_world_config.resident_width * g_world_config.resident_width;
+
+  return 0;
+}
+
+int load_profiler_config(void) {
+  g_profiler_config.history_frames = DEFAULT_PROFILER_HISTORY_FRAMES;
+  g_profiler_config.frame_budget_ms = DEFAULT_PROFILER_FRAME_BUDGET_MS;
+
+  if (!g_config) return -1;
+
+  cJSON *profiler = cJSON_GetObjectItem(g_config, "profiler");
+  if (profiler) {
+    cJSON *history = cJSON_GetObjectItem(profiler, "history_frames");
+    cJSON *budget = cJSON_GetObjectItem(profiler, "frame_budget_ms");
+
+    if (cJSON_IsNumber(history) && history->valueint >= 0) g_profiler_config.history_frames = history->valueint;
+    if (cJSON_IsNumber(budget)) g_profiler_config.frame_budget_ms = (float)budget->valuedouble;
+  }
 
   return 0;
 }
@@ -2,24 +2,52 @@
 #define CONFIG_H
 
 #include <cJSON.h>
+#include <stdbool.h>
 #include <stddef.h>
 
 // Global config object
 extern cJSON *g_config;
 
+// Upper bound on ground mesh resolutions per chunk
+#define MAX_GROUND_LODS 6
+
 // World configuration (loaded from config.json)
 typedef struct {
   int seed;
   int chunk_size;
   int half_chunk_size;
-  int ground_segments_per_chunk;
+  int ground_segments_per_chunk;   // segments per side of the coarsest ground LOD
   float ground_segment_size;
+  int ground_lod_levels;      // derived, level i has 2^i unit segments
+  float ground_lod_distance;  // camera distance covered by each ground LOD level
   int chunk_load_radius;
+  int resident_width;         // derived, side of the square of resident chunks (load radius plus one ring)
   int max_chunks;
+  int chunk_worker_threads;   // 0 picks one per logical core, minus the main thread
+  float chunk_hysteresis;     // world units the player must cross past a chunk border before chunks move
+  int chunk_cache_mb;         // memory budget for recently evicted chunks
+  int ground_texels_per_unit; // resolution of the baked ground material, 0 shades it per pixel instead
+  int tree_shadow_texels_per_unit; // resolution of the baked tree shadow masks, 0 disables tree shadows
+  float tree_impostor_distance;     // trees farther than this from the camera are drawn as sprites
+  int tree_archetype_variants;      // shared tree meshes generated per branch/level/segment combination
+  char chunk_store_dir[256];        // directory of the on-disk chunk store, empty (the default) disables it
+  int hiz_occluder_chunks;          // nearest chunks drawn before the Hi-Z pyramid is built, 0 disables occlusion culling
+  bool hiz_verify;                  // redraw everything the Hi-Z pyramid rejects to check it was hidden, slow, for testing
+  bool deferred_shading;            // shade each covered pixel once through a visibility buffer instead of per fragment
+  int snow_particles;               // falling snow flakes simulated around the player
+  bool pipelined_rendering;         // experimental: render frame N on its own thread while tick N + 1 runs, one tick of added latency
 } world_config_t;
 
 extern world_config_t g_world_config;
 
+// Profiler configuration (loaded from config.json)
+typedef struct {
+  int history_frames;       // frames kept in the profiler ring buffer
+  float frame_budget_ms;    // frames slower than this are logged as hitches
+} profiler_config_t;
+
+extern profiler_config_t g_profiler_config;
+
 // Load config.json and parse window parameters
 // Returns 0 on success, -1 on failure
 int load_config(unsigned int *width, unsigned int *height, unsigned int *scale, char *title, size_t title_size);
@@ -29,6 +57,11 @@ int load_config(unsigned int *width, unsigned int *height, unsigned int *scale,
 // Returns 0 on success, -1 on failure
 int load_world_config(void);
 
+// Load profiler configuration from config.json
+// Must be called after load_config()
+// Returns 0 on success, -1 on failure
+int load_profiler_config(void);
+
 // Free the global config object
 void free_config(void);
 
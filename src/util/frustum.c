@@ -0,0 +1,42 @@
+#include "frustum.h"
+
+#include <math.h>
+
+static frustum_plane_t make_plane(float3 normal, float3 point) {
+  return (frustum_plane_t){ .normal = normal, .distance = -float3_dot(normal, point) };
+}
+
+void init_frustum(frustum_t *frustum, const screen_projection_t *projection, const renderer_t *renderer) {
+  if (!frustum || !projection || !renderer) return;
+
+  float3 eye = projection->eye, view = projection->view, right = projection->right, up = projection->up;
+  float ppu = projection->pixels_per_unit;
+  float width = (float)renderer->width, height = (float)renderer->height;
+
+  frustum->planes[0] = make_plane(view, eye);
+  frustum->planes[1] = make_plane(float3_scale(view, -1.0f), float3_add(eye, float3_scale(view, renderer->max_depth)));
+
+  // side planes pass through the eye, 0 <= center_x + dot(p - eye, right) * ppu / depth <= width
+  // becomes dot(right * ppu + view * center_x, p - eye) >= 0 and its mirror for the other edge
+  frustum->planes[2] = make_plane(float3_add(float3_scale(right, ppu), float3_scale(view, projection->center_x)), eye);
+  frustum->planes[3] = make_plane(float3_sub(float3_scale(view, width - projection->center_x), float3_scale(right, ppu)), eye);
+  frustum->planes[4] = make_plane(float3_sub(float3_scale(view, projection->center_y), float3_scale(up, ppu)), eye);
+  frustum->planes[5] = make_plane(float3_add(float3_scale(up, ppu), float3_scale(view, height - projection->center_y)), eye);
+}
+
+bool frustum_test_aabb(const frustum_t *frustum, float3 aabb_min, float3 aabb_max) {
+  for (int i = 0; i < 6; ++i) {
+    const frustum_plane_t *plane = &frustum->planes[i];
+
+    // the corner furthest along the normal, if even that is outside the whole box is
+    float3 corner = make_float3(
+      plane->normal.x >= 0.0f ? aabb_max.x : aabb_min.x,
+      plane->normal.y >= 0.0f ? aabb_max.y : aabb_min.y,
+      plane->normal.z >= 0.0f ? aabb_max.z : aabb_min.z
+    );
+
+    if (float3_dot(plane->normal, corner) + plane->distance < 0.0f) return false;
+  }
+
+  return true;
+}
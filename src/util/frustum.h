@@ -0,0 +1,26 @@
+#ifndef __FRUSTUM_H__
+#define __FRUSTUM_H__
+
+#include <shader-works/maths.h>
+
+#include "projection.h"
+
+// Inside when dot(normal, p) + distance >= 0, normals are not normalized
+typedef struct {
+  float3 normal;
+  float distance;
+} frustum_plane_t;
+
+// Near, far, left, right, top and bottom planes of a camera's view volume in world space
+typedef struct {
+  frustum_plane_t planes[6];
+} frustum_t;
+
+// Planes through the screen edges of projection, out to the renderer's max_depth along the view
+void init_frustum(frustum_t *frustum, const screen_projection_t *projection, const renderer_t *renderer);
+
+// false only when the box lies fully outside one of the planes, so it may keep a few boxes that
+// straddle a frustum corner
+bool frustum_test_aabb(const frustum_t *frustum, float3 aabb_min, float3 aabb_max);
+
+#endif
@@ -0,0 +1,101 @@
+#include "hiz.h"
+
+#include <stdlib.h>
+
+int init_hiz(hiz_t *hiz, int width, int height) {
+  if (!hiz || width <= 0 || height <= 0) return -1;
+
+  *hiz = (hiz_t){ .width = width, .height = height };
+
+  // halve (rounding up) until a single texel covers the screen
+  usize total = 0;
+  int level_width = width, level_height = height;
+  do {
+    level_width = (level_width + 1) / 2;
+    level_height = (level_height + 1) / 2;
+
+    hiz->widths[hiz->num_levels] = level_width;
+    hiz->heights[hiz->num_levels] = level_height;
+    total += (usize)level_width * level_height;
+    hiz->num_levels++;
+  } while (hiz->num_levels < HIZ_MAX_LEVELS && (level_width > 1 || level_height > 1));
+
+  hiz->storage = malloc(total * sizeof(float));
+  if (!hiz->storage) {
+    *hiz = (hiz_t){0};
+    return -1;
+  }
+
+  float *level = hiz->storage;
+  for (int i = 0; i < hiz->num_levels; ++i) {
+    hiz->levels[i] = level;
+    level += (usize)hiz->widths[i] * hiz->heights[i];
+  }
+
+  return 0;
+}
+
+void free_hiz(hiz_t *hiz) {
+  if (!hiz) return;
+
+  free(hiz->storage);
+  *hiz = (hiz_t){0};
+}
+
+static inline float farther(float a, float b) {
+  return a > b ? a : b;
+}
+
+// Farthest of the 2x2 source texels under each destination texel, odd edges reuse the last row or column
+static void downsample(const float *src, int src_width, int src_height, float *dst, int dst_width, int dst_height) {
+  for (int y = 0; y < dst_height; ++y) {
+    const float *row0 = src + (usize)(y * 2) * src_width;
+    const float *row1 = src + (usize)(y * 2 + 1 < src_height ? y * 2 + 1 : y * 2) * src_width;
+
+    for (int x = 0; x < dst_width; ++x) {
+      int x0 = x * 2;
+      int x1 = x0 + 1 < src_width ? x0 + 1 : x0;
+      dst[(usize)y * dst_width + x] = farther(farther(row0[x0], row0[x1]), farther(row1[x0], row1[x1]));
+    }
+  }
+}
+
+void build_hiz(hiz_t *hiz, const float *depth_buffer) {
+  if (!hiz || !hiz->storage || !depth_buffer) return;
+
+  downsample(depth_buffer, hiz->width, hiz->height, hiz->levels[0], hiz->widths[0], hiz->heights[0]);
+  for (int i = 1; i < hiz->num_levels; ++i) {
+    downsample(hiz->levels[i - 1], hiz->widths[i - 1], hiz->heights[i - 1], hiz->levels[i], hiz->widths[i], hiz->heights[i]);
+  }
+}
+
+bool hiz_test_aabb(const hiz_t *hiz, const screen_projection_t *projection, float3 aabb_min, float3 aabb_max) {
+  if (!hiz || !hiz->storage) return false;
+
+  float2 screen_min, screen_max;
+  float nearest_depth;
+  if (!project_aabb(projection, aabb_min, aabb_max, &screen_min, &screen_max, &nearest_depth)) return false;
+
+  if (screen_max.x < 0.0f || screen_max.y < 0.0f || screen_min.x >= (float)hiz->width || screen_min.y >= (float)hiz->height) return false;
+
+  int x0 = screen_min.x > 0.0f ? (int)screen_min.x : 0;
+  int y0 = screen_min.y > 0.0f ? (int)screen_min.y : 0;
+  int x1 = screen_max.x < (float)(hiz->width - 1) ? (int)screen_max.x : hiz->width - 1;
+  int y1 = screen_max.y < (float)(hiz->height - 1) ? (int)screen_max.y : hiz->height - 1;
+
+  // coarsest detail where the rectangle touches at most 2x2 texels
+  int level = 0;
+  while (level < hiz->num_levels - 1 && ((x1 >> (level + 1)) - (x0 >> (level + 1)) > 1 || (y1 >> (level + 1)) - (y0 >> (level + 1)) > 1)) {
+    level++;
+  }
+
+  const float *texels = hiz->levels[level];
+  int shift = level + 1;
+  for (int y = y0 >> shift; y <= y1 >> shift; ++y) {
+    for (int x = x0 >> shift; x <= x1 >> shift; ++x) {
+      if (nearest_depth <= texels[(usize)y * hiz->widths[level] + x]) return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,29 @@
+#ifndef __HIZ_H__
+#define __HIZ_H__
+
+#include "projection.h"
+
+#define HIZ_MAX_LEVELS 16
+
+// Max depth pyramid of a depth buffer. A texel of level i holds the farthest depth of the
+// 2^(i+1) pixel square it covers, so anything nearer than the texels under it is visible
+typedef struct {
+  float *levels[HIZ_MAX_LEVELS];
+  int widths[HIZ_MAX_LEVELS], heights[HIZ_MAX_LEVELS];
+  int num_levels;
+  int width, height;    // resolution of the depth buffer the pyramid is built from
+  float *storage;       // every level in one block
+} hiz_t;
+
+// Room for the pyramid of a width x height depth buffer, returns 0 on success
+int init_hiz(hiz_t *hiz, int width, int height);
+void free_hiz(hiz_t *hiz);
+
+// Rebuild every level from depth_buffer, which must be width x height
+void build_hiz(hiz_t *hiz, const float *depth_buffer);
+
+// true when the box is behind what the pyramid was built from everywhere it covers on screen.
+// Boxes off screen or crossing the near plane are never reported occluded
+bool hiz_test_aabb(const hiz_t *hiz, const screen_projection_t *projection, float3 aabb_min, float3 aabb_max);
+
+#endif
@@ -0,0 +1,109 @@
+#include "mesh.h"
+
+#include <stdlib.h>
+
+#include <shader-works/maths.h>
+
+static usize grow_capacity(usize capacity, usize needed) {
+  if (capacity == 0) capacity = 64;
+  while (capacity < needed) capacity *= 2;
+  return capacity;
+}
+
+int indexed_mesh_reserve(indexed_mesh_t *mesh, usize extra_vertices, usize extra_indices) {
+  if (!mesh) return -1;
+
+  usize vertices_needed = mesh->num_vertices + extra_vertices;
+  usize indices_needed = mesh->num_indices + extra_indices;
+  if (vertices_needed > MAX_INDEXED_MESH_VERTICES) return -1;
+
+  if (vertices_needed > mesh->vertex_capacity) {
+    usize capacity = grow_capacity(mesh->vertex_capacity, vertices_needed);
+    if (capacity > MAX_INDEXED_MESH_VERTICES) capacity = MAX_INDEXED_MESH_VERTICES;
+
+    vertex_data_t *vertices = realloc(mesh->vertices, capacity * sizeof(vertex_data_t));
+    if (!vertices) return -1;
+
+    mesh->vertices = vertices;
+    mesh->vertex_capacity = capacity;
+  }
+
+  if (indices_needed > mesh->index_capacity) {
+    usize capacity = grow_capacity(mesh->index_capacity, indices_needed);
+
+    u16 *indices = realloc(mesh->indices, capacity * sizeof(u16));
+    if (!indices) return -1;
+
+    mesh->indices = indices;
+    mesh->index_capacity = capacity;
+  }
+
+  return 0;
+}
+
+void indexed_mesh_trim(indexed_mesh_t *mesh) {
+  if (!mesh || mesh->num_vertices == 0 || mesh->num_indices == 0) return;
+
+  // shrinking realloc may still fail, the larger block stays valid then
+  vertex_data_t *vertices = realloc(mesh->vertices, mesh->num_vertices * sizeof(vertex_data_t));
+  if (vertices) {
+    mesh->vertices = vertices;
+    mesh->vertex_capacity = mesh->num_vertices;
+  }
+
+  u16 *indices = realloc(mesh->indices, mesh->num_indices * sizeof(u16));
+  if (indices) {
+    mesh->indices = indices;
+    mesh->index_capacity = mesh->num_indices;
+  }
+}
+
+void free_indexed_mesh(indexed_mesh_t *mesh) {
+  if (!mesh) return;
+
+  free(mesh->vertices);
+  free(mesh->indices);
+  *mesh = (indexed_mesh_t){0};
+}
+
+int indexed_mesh_to_model(const indexed_mesh_t *mesh, model_t *model) {
+  if (!mesh || !model) return -1;
+
+  usize num_faces = mesh->num_indices / 3;
+  model->vertex_data = malloc(num_faces * 3 * sizeof(vertex_data_t));
+  model->face_normals = malloc(num_faces * sizeof(float3));
+  if (!model->vertex_data || !model->face_normals) {
+    delete_model(model);
+    return -1;
+  }
+
+  indexed_mesh_expand(mesh, mesh->vertices, model->vertex_data);
+  indexed_mesh_face_normals(mesh, model->face_normals);
+
+  model->num_vertices = num_faces * 3;
+  model->num_faces = num_faces;
+  return 0;
+}
+
+void indexed_mesh_face_normals(const indexed_mesh_t *mesh, float3 *out) {
+  for (usize f = 0; f < mesh->num_indices / 3; ++f) {
+    const vertex_data_t *v0 = &mesh->vertices[mesh->indices[f * 3]];
+    const vertex_data_t *v1 = &mesh->vertices[mesh->indices[f * 3 + 1]];
+    const vertex_data_t *v2 = &mesh->vertices[mesh->indices[f * 3 + 2]];
+
+    // collapsed triangles at tapered tips have no plane, they fall back to the shared normal
+    float3 normal = float3_cross(float3_sub(v2->position, v0->position), float3_sub(v1->position, v0->position));
+    out[f] = float3_magnitude(normal) > EPSILON * EPSILON ? float3_normalize(normal) : v0->normal;
+  }
+}
+
+void indexed_mesh_expand(const indexed_mesh_t *mesh, const vertex_data_t *vertices, vertex_data_t *out) {
+  for (usize i = 0; i < mesh->num_indices / 3 * 3; ++i) {
+    out[i] = vertices[mesh->indices[i]];
+  }
+}
+
+usize indexed_mesh_memory_size(const indexed_mesh_t *mesh) {
+  if (!mesh) return 0;
+  return mesh->vertex_capacity * sizeof(vertex_data_t) + mesh->index_capacity * sizeof(u16);
+}
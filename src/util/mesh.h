@@ -0,0 +1,41 @@
+#ifndef __MESH_H__
+#define __MESH_H__
+
+#include <shader-works/primitives.h>
+
+// 16 bit indices address at most this many vertices per mesh
+#define MAX_INDEXED_MESH_VERTICES 65536
+
+// Indexed triangle mesh for procedural geometry, vertices are shared between the triangles
+// that use them. render_model only draws triangle lists, indexed_mesh_expand gathers one
+typedef struct {
+  vertex_data_t *vertices;
+  u16 *indices;     // three per triangle
+  usize num_vertices, num_indices;
+  usize vertex_capacity, index_capacity;
+} indexed_mesh_t;
+
+// Grow the mesh so the given number of vertices and indices can be appended
+// Returns 0 on success, -1 when out of memory or past MAX_INDEXED_MESH_VERTICES
+int indexed_mesh_reserve(indexed_mesh_t *mesh, usize extra_vertices, usize extra_indices);
+
+// Release the capacity past the vertices and indices in use, for meshes that are complete
+void indexed_mesh_trim(indexed_mesh_t *mesh);
+
+void free_indexed_mesh(indexed_mesh_t *mesh);
+
+// Write the mesh into model as a triangle list with one face normal per triangle
+// Returns 0 on success, -1 when out of memory
+int indexed_mesh_to_model(const indexed_mesh_t *mesh, model_t *model);
+
+// One normal per triangle into out, which holds num_indices / 3 entries
+void indexed_mesh_face_normals(const indexed_mesh_t *mesh, float3 *out);
+
+// Gather vertices, one entry per mesh vertex, into out as a triangle list of one entry per index.
+// vertices may be a transformed copy of the mesh's own
+void indexed_mesh_expand(const indexed_mesh_t *mesh, const vertex_data_t *vertices, vertex_data_t *out);
+
+// Bytes of vertex and index data owned by the mesh
+usize indexed_mesh_memory_size(const indexed_mesh_t *mesh);
+
+#endif
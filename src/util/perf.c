@@ -0,0 +1,54 @@
+#include "perf.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+float perf_elapsed_ms(uint64_t start, uint64_t end) {
+  return (float)((double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+static int compare_floats(const void *a, const void *b) {
+  float fa = *(const float *)a;
+  float fb = *(const float *)b;
+
+  if (fa < fb) return -1;
+  if (fa > fb) return 1;
+  return 0;
+}
+
+// nearest-rank percentile on an already sorted buffer
+static float percentile(const float *sorted, size_t count, float p) {
+  size_t rank = (size_t)(p * (float)(count - 1) + 0.5f);
+  if (rank >= count) rank = count - 1;
+
+  return sorted[rank];
+}
+
+void perf_summarize(const float *samples, size_t count, perf_summary_t *out) {
+  if (!out) return;
+
+  memset(out, 0, sizeof(perf_summary_t));
+  if (!samples || count == 0) return;
+
+  float *sorted = malloc(count * sizeof(float));
+  if (!sorted) return;
+
+  memcpy(sorted, samples, count * sizeof(float));
+  qsort(sorted, count, sizeof(float), compare_floats);
+
+  double total = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    total += sorted[i];
+  }
+
+  out->min = sorted[0];
+  out->max = sorted[count - 1];
+  out->avg = (float)(total / (double)count);
+  out->p50 = percentile(sorted, count, 0.50f);
+  out->p95 = percentile(sorted, count, 0.95f);
+  out->p99 = percentile(sorted, count, 0.99f);
+
+  free(sorted);
+}
@@ -0,0 +1,19 @@
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Summary statistics over a set of timing samples (milliseconds)
+typedef struct {
+  float min, max, avg;
+  float p50, p95, p99;
+} perf_summary_t;
+
+// Convert a pair of SDL performance counter values to milliseconds
+float perf_elapsed_ms(uint64_t start, uint64_t end);
+
+// Compute min/max/avg and percentiles, samples are left untouched
+void perf_summarize(const float *samples, size_t count, perf_summary_t *out);
+
+#endif
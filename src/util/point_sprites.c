@@ -0,0 +1,69 @@
+#include "point_sprites.h"
+
+#include <math.h>
+
+// Points are projected a block at a time into flat arrays so the projection loop vectorizes
+#define SPRITE_BLOCK 256
+
+usize render_point_sprites(renderer_t *state, const screen_projection_t *projection, const float *xs, const float *ys, const float *zs, usize count, float size, u32 color) {
+  if (!state || !projection || !xs || !ys || !zs) return 0;
+
+  float depths[SPRITE_BLOCK], screen_xs[SPRITE_BLOCK], screen_ys[SPRITE_BLOCK];
+
+  const float3 eye = projection->eye, right = projection->right, up = projection->up, view = projection->view;
+  const float center_x = projection->center_x, center_y = projection->center_y;
+  const float near_depth = projection->near_depth, max_depth = state->max_depth;
+  const float sprite_scale = size * projection->pixels_per_unit;
+  const int width = (int)state->width, height = (int)state->height;
+
+  usize written = 0;
+  for (usize start = 0; start < count; start += SPRITE_BLOCK) {
+    usize block = count - start < SPRITE_BLOCK ? count - start : SPRITE_BLOCK;
+
+    for (usize i = 0; i < block; ++i) {
+      float dx = xs[start + i] - eye.x;
+      float dy = ys[start + i] - eye.y;
+      float dz = zs[start + i] - eye.z;
+
+      float depth = dx * view.x + dy * view.y + dz * view.z;
+      float scale = projection->pixels_per_unit / (depth > near_depth ? depth : near_depth);
+
+      depths[i] = depth;
+      screen_xs[i] = center_x + (dx * right.x + dy * right.y + dz * right.z) * scale;
+      screen_ys[i] = center_y - (dx * up.x + dy * up.y + dz * up.z) * scale;
+    }
+
+    for (usize i = 0; i < block; ++i) {
+      float depth = depths[i];
+      if (depth < near_depth || depth > max_depth) continue;
+
+      // at least a pixel wide so distant flakes do not vanish between pixel centers
+      int side = (int)(sprite_scale / depth + 0.5f);
+      if (side < 1) side = 1;
+
+      int x0 = (int)floorf(screen_xs[i] - 0.5f * (float)side + 0.5f);
+      int y0 = (int)floorf(screen_ys[i] - 0.5f * (float)side + 0.5f);
+      int x1 = x0 + side, y1 = y0 + side;
+
+      if (x0 < 0) x0 = 0;
+      if (y0 < 0) y0 = 0;
+      if (x1 > width) x1 = width;
+      if (y1 > height) y1 = height;
+
+      for (int y = y0; y < y1; ++y) {
+        float *depth_row = state->depth_buffer + (usize)y * width;
+        u32 *color_row = state->framebuffer + (usize)y * width;
+
+        for (int x = x0; x < x1; ++x) {
+          if (depth >= depth_row[x]) continue;
+
+          depth_row[x] = depth;
+          color_row[x] = color;
+          written++;
+        }
+      }
+    }
+  }
+
+  return written;
+}
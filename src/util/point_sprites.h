@@ -0,0 +1,11 @@
+#ifndef __POINT_SPRITES_H__
+#define __POINT_SPRITES_H__
+
+#include "projection.h"
+
+// Draw count points as depth tested squares of one color, size world units across, straight into
+// the renderer's framebuffer and depth buffer. Does the job of one camera facing quad per point
+// through render_model without vertex shading or triangle setup. Returns the pixels written
+usize render_point_sprites(renderer_t *state, const screen_projection_t *projection, const float *xs, const float *ys, const float *zs, usize count, float size, u32 color);
+
+#endif
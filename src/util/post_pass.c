@@ -0,0 +1,74 @@
+#include "post_pass.h"
+
+#include <float.h>
+
+#include "color.h"
+
+// shader-works' apply_fog_to_screen blends each pixel toward the fog color by how far its depth is
+// into [start, end], a linear ramp clamped at both ends. Pixels nothing wrote a depth to keep their
+// color, the sky is drawn in its own color behind the fog. tests/test_fog.c holds this against
+// apply_fog_to_screen
+typedef struct {
+  float start, scale;   // scale maps depth past start to a weight, COLOR_ONE at end
+} fog_ramp_t;
+
+static inline u32 fog_weight(const fog_ramp_t *ramp, float depth) {
+  float w = (depth - ramp->start) * ramp->scale;
+  w = w < 0.0f ? 0.0f : w;
+  w = w > (float)COLOR_ONE ? (float)COLOR_ONE : w;
+  return depth == FLT_MAX ? 0 : (u32)w;
+}
+
+static inline void finish_pixel(u32 *dst, u32 *color, float *depth, u32 fogged, u32 background) {
+  *dst = fogged;
+  *color = background;
+  *depth = FLT_MAX;
+}
+
+// Fog, copy and clear of every row, branch free so the blocks vectorize. Every buffer is touched
+// exactly once per pixel
+static inline void finish_rows(renderer_t *state, const fog_ramp_t *ramp, u32 fog_color, u32 background, u32 *out, usize out_stride) {
+  const u32 fog_colors[4] = { fog_color, fog_color, fog_color, fog_color };
+  const usize width = state->width;
+
+  for (uint y = 0; y < state->height; ++y) {
+    u32 *restrict color = state->framebuffer + (usize)y * width;
+    float *restrict depth = state->depth_buffer + (usize)y * width;
+    u32 *restrict dst = out + (usize)y * out_stride;
+
+    usize x = 0;
+    for (; x + 4 <= width; x += 4) {
+      u32 weights[4], fogged[4];
+      for (int i = 0; i < 4; ++i) weights[i] = fog_weight(ramp, depth[x + i]);
+      color_lerp_x4(fogged, color + x, fog_colors, weights);
+
+      for (int i = 0; i < 4; ++i) finish_pixel(&dst[x + i], &color[x + i], &depth[x + i], fogged[i], background);
+    }
+
+    for (; x < width; ++x) {
+      u32 fogged = color_lerp(color[x], fog_color, fog_weight(ramp, depth[x]));
+      finish_pixel(&dst[x], &color[x], &depth[x], fogged, background);
+    }
+  }
+}
+
+void post_process_frame(renderer_t *state, const fog_t *fog, u32 background, u32 *out, usize out_stride) {
+  if (!state || !fog || !out) return;
+
+  // no fog is a ramp with a zero scale, every weight is zero
+  fog_ramp_t ramp = { 0 };
+  if (fog->enabled && fog->end > fog->start) {
+    ramp = (fog_ramp_t){ .start = fog->start, .scale = (float)COLOR_ONE / (fog->end - fog->start) };
+  }
+  finish_rows(state, &ramp, fog->color, background, out, out_stride);
+}
+
+void clear_frame_buffers(renderer_t *state, u32 background) {
+  if (!state) return;
+
+  usize num_pixels = (usize)state->width * state->height;
+  for (usize i = 0; i < num_pixels; ++i) {
+    state->framebuffer[i] = background;
+    state->depth_buffer[i] = FLT_MAX;
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef __POST_PASS_H__
+#define __POST_PASS_H__
+
+#include <shader-works/renderer.h>
+
+// Fog toward color between start and end depth, shaped like shader-works' apply_fog_to_screen,
+// nothing is fogged when disabled
+typedef struct {
+  bool enabled;
+  float start, end;
+  u32 color;
+} fog_t;
+
+// The end of a frame in one pass over the renderer's buffers: every pixel gets the fog applied and
+// is written to out, rows out_stride pixels apart, as apply_fog_to_screen followed by a copy would.
+// Pixels keep what was drawn on them whether or not it wrote a depth, only those with one are fogged.
+// The framebuffer is reset to background and the depth buffer to FLT_MAX behind it, so the next
+// frame needs no separate clear. out must not be the renderer's framebuffer
+void post_process_frame(renderer_t *state, const fog_t *fog, u32 background, u32 *out, usize out_stride);
+
+// Reset the renderer's buffers the way post_process_frame leaves them, for the first frame
+void clear_frame_buffers(renderer_t *state, u32 background);
+
+#endif
@@ -0,0 +1,179 @@
+#include "profiler.h"
+#include "perf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+profiler_t g_profiler = {0};
+
+static const char *phase_names[PROFILE_NUM_PHASES] = {
+  "tick",
+  "chunk_update",
+  "chunk_gen",
+  "render_chunks",
+  "hiz_build",
+  "render_quads",
+  "resolve",
+  "post",
+  "present",
+  "frame",
+};
+
+const char *profiler_phase_name(profile_phase_t phase) {
+  return phase < PROFILE_NUM_PHASES ? phase_names[phase] : "unknown";
+}
+
+void profiler_init(size_t capacity, float budget_ms) {
+  profiler_free();
+  if (capacity == 0) return;
+
+  g_profiler.frames = calloc(capacity, sizeof(profile_frame_t));
+  if (!g_profiler.frames) return;
+
+  g_profiler.capacity = capacity;
+  g_profiler.budget_ms = budget_ms;
+}
+
+void profiler_free(void) {
+  free(g_profiler.frames);
+  g_profiler = (profiler_t){0};
+}
+
+void profiler_frame_begin(void) {
+  if (!g_profiler.frames) return;
+
+  memset(&g_profiler.current, 0, sizeof(profile_frame_t));
+  g_profiler.frame_start = SDL_GetPerformanceCounter();
+}
+
+static void log_hitch(const profile_frame_t *frame) {
+  printf("Hitch: frame %lu took %.2f ms (budget %.2f ms) [tick %.2f, chunk_gen %.2f, render %.2f]",
+         (unsigned long)g_profiler.frame_index, frame->phase_ms[PROFILE_FRAME], g_profiler.budget_ms,
+         frame->phase_ms[PROFILE_TICK], frame->phase_ms[PROFILE_CHUNK_GEN],
+         frame->phase_ms[PROFILE_RENDER_CHUNKS] + frame->phase_ms[PROFILE_RENDER_QUADS]);
+
+  if (frame->num_generated_chunks > 0) {
+    printf(" generated:");
+    for (size_t i = 0; i < frame->num_generated_chunks; ++i) {
+      printf(" (%d, %d)", frame->generated_chunks[i][0], frame->generated_chunks[i][1]);
+    }
+  }
+
+  printf("\n");
+}
+
+void profiler_frame_end(void) {
+  if (!g_profiler.frames) return;
+
+  profile_frame_t *frame = &g_profiler.current;
+  frame->phase_ms[PROFILE_FRAME] = perf_elapsed_ms(g_profiler.frame_start, SDL_GetPerformanceCounter());
+
+  if (g_profiler.budget_ms > 0.0f && frame->phase_ms[PROFILE_FRAME] > g_profiler.budget_ms) {
+    g_profiler.num_hitches++;
+    log_hitch(frame);
+  }
+
+  g_profiler.frames[g_profiler.head] = *frame;
+  g_profiler.head = (g_profiler.head + 1) % g_profiler.capacity;
+  if (g_profiler.count < g_profiler.capacity) g_profiler.count++;
+
+  g_profiler.frame_index++;
+}
+
+void profiler_begin(profile_phase_t phase) {
+  if (!g_profiler.frames || phase >= PROFILE_NUM_PHASES) return;
+
+  g_profiler.phase_start[phase] = SDL_GetPerformanceCounter();
+}
+
+void profiler_end(profile_phase_t phase) {
+  if (!g_profiler.frames || phase >= PROFILE_NUM_PHASES) return;
+
+  g_profiler.current.phase_ms[phase] += perf_elapsed_ms(g_profiler.phase_start[phase], SDL_GetPerformanceCounter());
+}
+
+void profiler_add(profile_phase_t phase, float ms) {
+  if (!g_profiler.frames || phase >= PROFILE_NUM_PHASES) return;
+
+  g_profiler.current.phase_ms[phase] += ms;
+}
+
+void profiler_note_chunk(int x, int z) {
+  if (!g_profiler.frames) return;
+
+  profile_frame_t *frame = &g_profiler.current;
+  if (frame->num_generated_chunks >= PROFILER_MAX_FRAME_CHUNKS) return;
+
+  frame->generated_chunks[frame->num_generated_chunks][0] = x;
+  frame->generated_chunks[frame->num_generated_chunks][1] = z;
+  frame->num_generated_chunks++;
+}
+
+// oldest to newest index into the ring
+static inline size_t ring_index(size_t i) {
+  return (g_profiler.head + g_profiler.capacity - g_profiler.count + i) % g_profiler.capacity;
+}
+
+void profiler_print_summary(void) {
+  if (!g_profiler.frames || g_profiler.count == 0) return;
+
+  float *samples = malloc(g_profiler.count * sizeof(float));
+  if (!samples) return;
+
+  printf("Profile over last %zu frames (%lu hitches over %.2f ms):\n",
+         g_profiler.count, (unsigned long)g_profiler.num_hitches, g_profiler.budget_ms);
+
+  for (int phase = 0; phase < PROFILE_NUM_PHASES; ++phase) {
+    for (size_t i = 0; i < g_profiler.count; ++i) {
+      samples[i] = g_profiler.frames[ring_index(i)].phase_ms[phase];
+    }
+
+    perf_summary_t summary;
+    perf_summarize(samples, g_profiler.count, &summary);
+
+    printf("  %-14s p50 %7.3f ms  p95 %7.3f ms  p99 %7.3f ms  max %7.3f ms\n",
+           phase_names[phase], summary.p50, summary.p95, summary.p99, summary.max);
+  }
+
+  free(samples);
+}
+
+int profiler_export_csv(const char *path) {
+  if (!g_profiler.frames || !path) return -1;
+
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    printf("Failed to open %s for profiler export\n", path);
+    return -1;
+  }
+
+  fprintf(file, "frame");
+  for (int phase = 0; phase < PROFILE_NUM_PHASES; ++phase) {
+    fprintf(file, ",%s_ms", phase_names[phase]);
+  }
+  fprintf(file, ",generated_chunks\n");
+
+  uint64_t first_frame = g_profiler.frame_index - g_profiler.count;
+  for (size_t i = 0; i < g_profiler.count; ++i) {
+    const profile_frame_t *frame = &g_profiler.frames[ring_index(i)];
+
+    fprintf(file, "%lu", (unsigned long)(first_frame + i));
+    for (int phase = 0; phase < PROFILE_NUM_PHASES; ++phase) {
+      fprintf(file, ",%.4f", frame->phase_ms[phase]);
+    }
+
+    // chunk list as x:z pairs separated by spaces so it stays one column
+    fprintf(file, ",");
+    for (size_t c = 0; c < frame->num_generated_chunks; ++c) {
+      fprintf(file, "%s%d:%d", c ? " " : "", frame->generated_chunks[c][0], frame->generated_chunks[c][1]);
+    }
+    fprintf(file, "\n");
+  }
+
+  fclose(file);
+  printf("Wrote %zu profiled frames to %s\n", g_profiler.count, path);
+  return 0;
+}
@@ -0,0 +1,73 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROFILER_MAX_FRAME_CHUNKS 16
+
+// Timed sections of a frame, a phase can be entered several times per frame and accumulates
+typedef enum {
+  PROFILE_TICK,           // fsm_tick_state, all ticks run this frame, overlaps rendering when pipelined
+  PROFILE_CHUNK_UPDATE,   // update_loaded_chunks, includes generation
+  PROFILE_CHUNK_GEN,      // generate_chunk, worker time of chunks published this frame
+  PROFILE_RENDER_CHUNKS,  // render_loaded_chunks
+  PROFILE_HIZ_BUILD,      // build_hiz, nested in render_loaded_chunks
+  PROFILE_RENDER_QUADS,   // render_quads
+  PROFILE_RESOLVE,        // resolve_visibility_buffer, deferred shading only
+  PROFILE_POST,           // post_process_frame: fog, copy to the presentation buffer and clear
+  PROFILE_PRESENT,        // SDL_RenderTexture and present
+  PROFILE_FRAME,          // whole frame, set by profiler_frame_end
+  PROFILE_NUM_PHASES
+} profile_phase_t;
+
+typedef struct {
+  float phase_ms[PROFILE_NUM_PHASES];
+
+  // chunks generated by the ticks of this frame, for hitch attribution
+  int generated_chunks[PROFILER_MAX_FRAME_CHUNKS][2];
+  size_t num_generated_chunks;
+} profile_frame_t;
+
+typedef struct {
+  profile_frame_t *frames;    // ring buffer of the last `capacity` frames
+  size_t capacity, head, count;
+  uint64_t frame_index;
+
+  profile_frame_t current;
+  uint64_t phase_start[PROFILE_NUM_PHASES];
+  uint64_t frame_start;
+
+  float budget_ms;            // frames above this are logged as hitches
+  uint64_t num_hitches;
+} profiler_t;
+
+extern profiler_t g_profiler;
+
+// Allocate the sample ring, profiling calls are no-ops until this is called
+void profiler_init(size_t capacity, float budget_ms);
+void profiler_free(void);
+
+void profiler_frame_begin(void);
+void profiler_frame_end(void);
+
+void profiler_begin(profile_phase_t phase);
+void profiler_end(profile_phase_t phase);
+
+// Add time measured elsewhere (e.g. on a worker thread) to a phase of the current frame
+void profiler_add(profile_phase_t phase, float ms);
+
+// Record a chunk generated during the current frame
+void profiler_note_chunk(int x, int z);
+
+// Print p50/p95/p99 per phase over the frames currently held in the ring
+void profiler_print_summary(void);
+
+// Write every frame in the ring as one CSV row
+// Returns 0 on success, -1 on failure
+int profiler_export_csv(const char *path);
+
+const char *profiler_phase_name(profile_phase_t phase);
+
+#endif
@@ -0,0 +1,73 @@
+#include "projection.h"
+
+#include <float.h>
+#include <math.h>
+
+#define PROJECTION_NEAR_DEPTH 0.01f
+
+void init_screen_projection(screen_projection_t *projection, const renderer_t *renderer, transform_t *camera) {
+  if (!projection || !renderer || !camera) return;
+
+  float3 right, up, forward;
+  transform_get_basis_vectors(camera, &right, &up, &forward);
+
+  *projection = (screen_projection_t){
+    .eye = camera->position,
+    .right = right,
+    .up = up,
+    .view = float3_scale(forward, -1.0f),
+    .center_x = (float)renderer->width * 0.5f,
+    .center_y = (float)renderer->height * 0.5f,
+    .pixels_per_unit = (float)renderer->height / (2.0f * tanf(renderer->fov * 0.5f)),
+    .near_depth = PROJECTION_NEAR_DEPTH
+  };
+}
+
+bool project_to_screen(const screen_projection_t *projection, float3 p, float3 *screen) {
+  float3 offset = float3_sub(p, projection->eye);
+  float depth = float3_dot(offset, projection->view);
+  if (depth < projection->near_depth) return false;
+
+  float scale = projection->pixels_per_unit / depth;
+  *screen = make_float3(
+    projection->center_x + float3_dot(offset, projection->right) * scale,
+    projection->center_y - float3_dot(offset, projection->up) * scale,
+    depth
+  );
+  return true;
+}
+
+float3 unproject_from_screen(const screen_projection_t *projection, float x, float y, float depth) {
+  float scale = depth / projection->pixels_per_unit;
+  float3 offset = float3_add(
+    float3_scale(projection->view, depth),
+    float3_add(float3_scale(projection->right, (x - projection->center_x) * scale), float3_scale(projection->up, (projection->center_y - y) * scale))
+  );
+  return float3_add(projection->eye, offset);
+}
+
+bool project_aabb(const screen_projection_t *projection, float3 aabb_min, float3 aabb_max, float2 *screen_min, float2 *screen_max, float *nearest_depth) {
+  float2 lo = make_float2(FLT_MAX, FLT_MAX);
+  float2 hi = make_float2(-FLT_MAX, -FLT_MAX);
+  float nearest = FLT_MAX;
+
+  for (int corner = 0; corner < 8; ++corner) {
+    float3 p = make_float3(
+      (corner & 1) ? aabb_max.x : aabb_min.x,
+      (corner & 2) ? aabb_max.y : aabb_min.y,
+      (corner & 4) ? aabb_max.z : aabb_min.z
+    );
+
+    float3 screen;
+    if (!project_to_screen(projection, p, &screen)) return false;
+
+    lo = make_float2(fminf(lo.x, screen.x), fminf(lo.y, screen.y));
+    hi = make_float2(fmaxf(hi.x, screen.x), fmaxf(hi.y, screen.y));
+    nearest = fminf(nearest, screen.z);
+  }
+
+  *screen_min = lo;
+  *screen_max = hi;
+  *nearest_depth = nearest;
+  return true;
+}
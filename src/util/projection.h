@@ -0,0 +1,31 @@
+#ifndef __PROJECTION_H__
+#define __PROJECTION_H__
+
+#include <shader-works/renderer.h>
+#include <shader-works/maths.h>
+
+// World to screen mapping of a renderer and camera, the same perspective render_model applies:
+// the camera looks down -forward of its basis (the way apply_fps_movement walks), renderer->fov is
+// the vertical field of view in radians, the screen center is at (width / 2, height / 2) and depth
+// is the distance along the view direction. tests/test_projection.c checks all of it against
+// quads drawn by render_model
+typedef struct {
+  float3 eye, right, up, view;  // right and up point along increasing x and decreasing y on screen
+  float center_x, center_y;
+  float pixels_per_unit;        // a unit at depth 1 spans this many pixels
+  float near_depth;             // points closer than this are not projected
+} screen_projection_t;
+
+void init_screen_projection(screen_projection_t *projection, const renderer_t *renderer, transform_t *camera);
+
+// Pixel position and depth of p in screen, false when p is not in front of the near plane
+bool project_to_screen(const screen_projection_t *projection, float3 p, float3 *screen);
+
+// World position that projects to pixel position (x, y) at depth, the inverse of project_to_screen
+float3 unproject_from_screen(const screen_projection_t *projection, float x, float y, float depth);
+
+// Pixel rectangle covering the box and the depth of its nearest corner, false when part of the
+// box is not in front of the near plane and no rectangle bounds it
+bool project_aabb(const screen_projection_t *projection, float3 aabb_min, float3 aabb_max, float2 *screen_min, float2 *screen_max, float *nearest_depth);
+
+#endif
@@ -0,0 +1,95 @@
+#include "snow_ground.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+int init_snow_ground(snow_ground_t *ground, float radius) {
+  if (!ground || radius <= 0.0f) return -1;
+
+  int size = (int)ceilf(radius / SNOW_GROUND_STEP) * 2 + 2;
+  *ground = (snow_ground_t){ .size = size };
+  ground->heights = malloc(sizeof(float) * (size_t)size * size);
+  if (!ground->heights) {
+    *ground = (snow_ground_t){0};
+    return -1;
+  }
+
+  return 0;
+}
+
+void free_snow_ground(snow_ground_t *ground) {
+  if (!ground) return;
+
+  free(ground->heights);
+  *ground = (snow_ground_t){0};
+}
+
+void update_snow_ground(snow_ground_t *ground, float x, float z, snow_ground_sampler_t sample, void *args) {
+  int cell_x = (int)floorf(x / SNOW_GROUND_STEP);
+  int cell_z = (int)floorf(z / SNOW_GROUND_STEP);
+  if (ground->valid && cell_x == ground->cell_x && cell_z == ground->cell_z) return;
+
+  int size = ground->size;
+  int half = size / 2;
+  int shift_x = cell_x - ground->cell_x;
+  int shift_z = cell_z - ground->cell_z;
+  bool scroll = ground->valid && abs(shift_x) < size && abs(shift_z) < size;
+
+  // samples still in range move to their new place, rows are walked in the direction that reads
+  // each row before it is overwritten
+  if (scroll) {
+    int kept = size - abs(shift_x);
+    int dst_x = shift_x < 0 ? -shift_x : 0, src_x = shift_x > 0 ? shift_x : 0;
+
+    for (int i = 0; i < size; i++) {
+      int row = shift_z > 0 ? i : size - 1 - i;
+      if (row + shift_z < 0 || row + shift_z >= size) continue;
+
+      float *dst = ground->heights + row * size + dst_x;
+      const float *src = ground->heights + (row + shift_z) * size + src_x;
+      memmove(dst, src, sizeof(float) * (size_t)kept);
+    }
+  }
+
+  ground->cell_x = cell_x;
+  ground->cell_z = cell_z;
+  ground->origin_x = (float)(cell_x - half) * SNOW_GROUND_STEP;
+  ground->origin_z = (float)(cell_z - half) * SNOW_GROUND_STEP;
+
+  for (int row = 0; row < size; row++) {
+    // a kept row only needs the columns that scrolled in
+    int x0 = 0, x1 = size;
+    if (scroll && row + shift_z >= 0 && row + shift_z < size) {
+      x0 = shift_x > 0 ? size - shift_x : 0;
+      x1 = shift_x > 0 ? size : -shift_x;
+    }
+
+    for (int col = x0; col < x1; col++) {
+      float wx = ground->origin_x + (float)col * SNOW_GROUND_STEP;
+      float wz = ground->origin_z + (float)row * SNOW_GROUND_STEP;
+      ground->heights[row * size + col] = sample(args, wx, wz);
+    }
+  }
+
+  ground->valid = true;
+}
+
+float snow_ground_height(const snow_ground_t *ground, float x, float z) {
+  float gx = (x - ground->origin_x) / SNOW_GROUND_STEP;
+  float gz = (z - ground->origin_z) / SNOW_GROUND_STEP;
+
+  // flakes are culled at the grid radius, the grid covers that plus a cell, clamp for safety
+  float max = (float)(ground->size - 1) - 0.001f;
+  gx = gx < 0.0f ? 0.0f : (gx > max ? max : gx);
+  gz = gz < 0.0f ? 0.0f : (gz > max ? max : gz);
+
+  int ix = (int)gx, iz = (int)gz;
+  float fx = gx - (float)ix, fz = gz - (float)iz;
+
+  const float *row0 = ground->heights + iz * ground->size + ix;
+  const float *row1 = row0 + ground->size;
+  float h0 = row0[0] + (row0[1] - row0[0]) * fx;
+  float h1 = row1[0] + (row1[1] - row1[0]) * fx;
+  return h0 + (h1 - h0) * fz;
+}
@@ -0,0 +1,31 @@
+#ifndef __SNOW_GROUND_H__
+#define __SNOW_GROUND_H__
+
+#include <stdbool.h>
+
+// Terrain heights on a coarse grid around the player. Flakes collide against this instead of
+// sampling the chunk heightfields. When the player crosses a grid cell the samples are scrolled
+// and only the rows and columns that came into range are sampled
+#define SNOW_GROUND_STEP 2.0f
+
+typedef float (*snow_ground_sampler_t)(void *args, float x, float z);
+
+typedef struct {
+  float *heights;
+  int size;                   // samples per side
+  int cell_x, cell_z;         // grid cell the player was in when it was filled
+  float origin_x, origin_z;   // world position of sample (0, 0)
+  bool valid;
+} snow_ground_t;
+
+// Room for a grid reaching radius past the player on every side, returns 0 on success
+int init_snow_ground(snow_ground_t *ground, float radius);
+void free_snow_ground(snow_ground_t *ground);
+
+// Recenter the grid on the player, sampling only what scrolled in
+void update_snow_ground(snow_ground_t *ground, float x, float z, snow_ground_sampler_t sample, void *args);
+
+// Bilinear height at (x, z), positions off the grid are clamped to its edge
+float snow_ground_height(const snow_ground_t *ground, float x, float z);
+
+#endif
@@ -0,0 +1,140 @@
+// A frame drawn through render_model with the visibility shaders and resolved must match the same
+// frame shaded forward: every covered pixel keeps the id it was drawn with, and the resolve hands
+// the material shader the position, normal and lights render_model would have
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <shader-works/renderer.h>
+
+#include "scene.h"
+#include "util/color.h"
+
+#define WIDTH 160
+#define HEIGHT 120
+#define MAX_DEPTH 60.0f
+#define NUM_QUADS 5
+
+// The bark pattern changes every 2cm of world position, far below a pixel here, so a pixel whose
+// rebuilt position lands across a cell edge from the rasterized one shades differently. Most must
+// match, a context missing the normal or lights changes all of them
+#define CHANNEL_TOLERANCE 3
+#define MIN_MATCHING 0.9
+
+extern fragment_shader_t tree_frag;             // in shaders.c
+extern fragment_shader_t tree_visibility_frag;  // in deferred.c
+
+static u32 framebuffer[WIDTH * HEIGHT];
+static float depth_buffer[WIDTH * HEIGHT];
+static u32 forward[WIDTH * HEIGHT];
+static float forward_depth[WIDTH * HEIGHT];
+static scene_t scene;
+
+static void clear(void) {
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    framebuffer[i] = 0;
+    depth_buffer[i] = FLT_MAX;
+  }
+}
+
+// Quads facing different ways at different depths, overlapping on screen. Both windings are drawn
+// with the same normal so back face culling keeps one of each pair
+static void draw_quads(renderer_t *renderer, transform_t *camera, fragment_shader_t *shader, light_t *light) {
+  for (int q = 0; q < NUM_QUADS; ++q) {
+    float3 center = make_float3(-4.0f + 2.0f * (float)q, 0.5f * (float)q, -10.0f - 3.0f * (float)q);
+    float tilt = -0.9f + 0.45f * (float)q;
+    float3 right = make_float3(cosf(tilt) * 2.5f, 0.0f, sinf(tilt) * 2.5f);
+    float3 up = make_float3(0.0f, 2.5f, 0.6f * (float)(q - 2));
+    float3 normal = float3_normalize(float3_cross(up, right));
+
+    const float3 corners[4] = {
+      float3_sub(float3_sub(center, right), up), float3_sub(float3_add(center, right), up),
+      float3_add(float3_add(center, right), up), float3_add(float3_sub(center, right), up)
+    };
+    const int order[12] = { 0, 1, 2, 0, 2, 3, 0, 2, 1, 0, 3, 2 };
+
+    vertex_data_t vertices[12];
+    float3 face_normals[4] = { normal, normal, normal, normal };
+    for (int i = 0; i < 12; ++i) vertices[i] = (vertex_data_t){ .position = corners[order[i]], .normal = normal };
+
+    model_t model = { 0 };
+    model.vertex_data = vertices;
+    model.face_normals = face_normals;
+    model.num_vertices = 12;
+    model.num_faces = 4;
+    model.frag_shader = shader;
+    render_model(renderer, camera, &model, light, 1);
+  }
+}
+
+static inline int channel_difference(u32 a, u32 b, int shift) {
+  return abs((int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff));
+}
+
+int main(void) {
+  renderer_t renderer = { 0 };
+  init_renderer(&renderer, WIDTH, HEIGHT, 0, 0, framebuffer, depth_buffer, MAX_DEPTH);
+
+  transform_t camera = { 0 };
+  camera.position = make_float3(0.0f, 1.0f, 2.0f);
+  camera.pitch = -0.05f;
+  update_camera(&renderer, &camera);
+  scene.camera_pos = camera;
+
+  light_t sun = { .is_directional = true, .direction = float3_normalize(make_float3(1, -1, 1)), .color = rgb_to_u32(200, 160, 160) };
+
+  clear();
+  draw_quads(&renderer, &camera, &tree_frag, &sun);
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    forward[i] = framebuffer[i];
+    forward_depth[i] = depth_buffer[i];
+  }
+
+  clear();
+  draw_quads(&renderer, &camera, &tree_visibility_frag, &sun);
+
+  int failures = 0;
+  usize covered = 0;
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    if ((depth_buffer[i] == FLT_MAX) != (forward_depth[i] == FLT_MAX)) failures++;
+    if (depth_buffer[i] == FLT_MAX) continue;
+
+    covered++;
+    if (framebuffer[i] >> 28 != 2) {
+      if (failures++ < 5) printf("pixel %zu: id %08x is not a tree id\n", i, framebuffer[i]);
+    }
+  }
+
+  if (covered < WIDTH * HEIGHT / 10) {
+    printf("quads cover %zu pixels, the camera does not see them\n", covered);
+    return 1;
+  }
+
+  usize shaded = resolve_visibility_buffer(&renderer, &scene, &sun, 1);
+  if (shaded != covered) {
+    printf("resolve shaded %zu of %zu covered pixels\n", shaded, covered);
+    failures++;
+  }
+
+  usize matching = 0;
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    if (depth_buffer[i] == FLT_MAX) continue;
+    matching += channel_difference(framebuffer[i], forward[i], COLOR_R_SHIFT) <= CHANNEL_TOLERANCE &&
+                channel_difference(framebuffer[i], forward[i], COLOR_G_SHIFT) <= CHANNEL_TOLERANCE &&
+                channel_difference(framebuffer[i], forward[i], COLOR_B_SHIFT) <= CHANNEL_TOLERANCE;
+  }
+
+  if ((double)matching < MIN_MATCHING * (double)covered) {
+    printf("resolved colors match forward shading on %zu of %zu pixels\n", matching, covered);
+    failures++;
+  }
+
+  if (failures) {
+    printf("test_deferred: %d failures\n", failures);
+    return 1;
+  }
+
+  printf("test_deferred: %zu pixels, %zu resolved as shaded forward\n", covered, matching);
+  return 0;
+}
@@ -0,0 +1,184 @@
+// Ground and tree draws replayed from a draw list must cover the pixels, at the depths and in the
+// colors, of the same meshes placed on the CPU and submitted to render_model one by one, and must
+// leave the shared ground and archetype models as they were
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <shader-works/renderer.h>
+
+#include "scene.h"
+#include "util/config.h"
+
+#define WIDTH 160
+#define HEIGHT 120
+#define MAX_DEPTH 60.0f
+#define NUM_GROUND 3
+#define NUM_TREES 8
+
+// pixels along triangle edges may round either way, anything past this share is a misplaced draw
+#define MAX_MISMATCH_SHARE 0.02f
+
+static u32 framebuffer[WIDTH * HEIGHT];
+static float depth_buffer[WIDTH * HEIGHT];
+static u32 reference[WIDTH * HEIGHT];
+static float reference_depth[WIDTH * HEIGHT];
+static vertex_data_t placed[1 << 16];
+
+// A color per world cell, so a draw in the wrong place or turned differently shades differently
+static u32 cell_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)args; (void)argc;
+  int x = (int)floorf(ctx->world_pos.x), y = (int)floorf(ctx->world_pos.y * 2.0f), z = (int)floorf(ctx->world_pos.z);
+  u32 hash = (u32)(x * 73856093) ^ (u32)(y * 19349663) ^ (u32)(z * 83492791);
+  return (hash | 0xffu) & ~0x80000000u;
+}
+
+static fragment_shader_t cell_frag = { .func = cell_func, .argv = NULL, .argc = 0, .valid = true };
+
+static void clear(void) {
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    framebuffer[i] = 0;
+    depth_buffer[i] = FLT_MAX;
+  }
+}
+
+// A 4 by 4 ground tile, both windings so it shows from above and below
+static void build_ground(model_t *model, vertex_data_t *vertices, float3 *face_normals) {
+  const float3 corners[4] = { { 0, 0, 0 }, { 4, 0, 0 }, { 4, 0.5f, 4 }, { 0, 0.5f, 4 } };
+  const int order[12] = { 0, 1, 2, 0, 2, 3, 0, 2, 1, 0, 3, 2 };
+  for (int i = 0; i < 12; ++i) vertices[i] = (vertex_data_t){ .position = corners[order[i]], .normal = make_float3(0, 1, 0) };
+  for (int i = 0; i < 4; ++i) face_normals[i] = make_float3(0, 1, 0);
+
+  *model = (model_t){ 0 };
+  model->vertex_data = vertices;
+  model->face_normals = face_normals;
+  model->num_vertices = 12;
+  model->num_faces = 4;
+}
+
+// The draw's mesh moved into world space on the CPU and drawn with an identity transform
+static usize draw_placed(renderer_t *renderer, transform_t *camera, const model_t *mesh, const tree_instance_t *tree, float3 position) {
+  tree_transform_t turn = tree ? tree_instance_transform(tree) : (tree_transform_t){ 0 };
+  for (usize v = 0; v < mesh->num_vertices; ++v) {
+    float3 p = mesh->vertex_data[v].position;
+    placed[v] = mesh->vertex_data[v];
+    placed[v].position = float3_add(position, tree ? tree_transform_direction(&turn, p) : p);
+  }
+
+  model_t model = *mesh;
+  model.vertex_data = placed;
+  model.transform = (transform_t){ 0 };
+  model.frag_shader = &cell_frag;
+  return render_model(renderer, camera, &model, NULL, 0);
+}
+
+int main(void) {
+  if (load_world_config() != 0 || init_tree_library() != 0) {
+    printf("could not set up the tree library\n");
+    return 1;
+  }
+
+  renderer_t renderer = { 0 };
+  init_renderer(&renderer, WIDTH, HEIGHT, 0, 0, framebuffer, depth_buffer, MAX_DEPTH);
+
+  transform_t camera = { 0 };
+  camera.position = make_float3(0.0f, 4.0f, 8.0f);
+  camera.pitch = -0.25f;
+  update_camera(&renderer, &camera);
+
+  vertex_data_t ground_vertices[12];
+  float3 ground_normals[4];
+  model_t ground;
+  build_ground(&ground, ground_vertices, ground_normals);
+
+  tree_instance_t trees[NUM_TREES];
+  for (int t = 0; t < NUM_TREES; ++t) {
+    trees[t] = (tree_instance_t){ .archetype = (u16)t, .yaw = (u8)(t * 37), .scale = (u8)(t * 255 / (NUM_TREES - 1)) };
+    trees[t].position = make_float3(-9.0f + 2.6f * (float)t, 0.0f, -6.0f - 2.0f * (float)(t % 3));
+  }
+
+  // ground first, then trees, the order render_loaded_chunks records them in
+  draw_list_t list = { 0 };
+  for (int g = 0; g < NUM_GROUND; ++g) {
+    draw_item_t item = { .model = &ground, .position = make_float3(-6.0f + 4.0f * (float)g, 0.0f, -4.0f - 3.0f * (float)g), .frag_shader = &cell_frag };
+    push_draw_item(&list, &item);
+  }
+  for (int t = 0; t < NUM_TREES; ++t) {
+    draw_item_t item = { .position = trees[t].position, .tree = &trees[t], .frag_shader = &cell_frag };
+    push_draw_item(&list, &item);
+  }
+
+  model_t ground_before = ground;
+  model_t archetype_before[NUM_TREES];
+  for (int t = 0; t < NUM_TREES; ++t) archetype_before[t] = tree_archetype(trees[t].archetype)->models[tree_instance_scale_step(&trees[t])];
+
+  int failures = 0;
+
+  clear();
+  usize reference_triangles = 0;
+  for (usize i = 0; i < list.count; ++i) {
+    const draw_item_t *item = &list.items[i];
+    const model_t *mesh = item->tree ? &tree_archetype(item->tree->archetype)->models[tree_instance_scale_step(item->tree)] : item->model;
+    reference_triangles += draw_placed(&renderer, &camera, mesh, item->tree, item->position);
+  }
+
+  usize covered = 0;
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    reference[i] = framebuffer[i];
+    reference_depth[i] = depth_buffer[i];
+    covered += depth_buffer[i] != FLT_MAX;
+  }
+
+  // the whole list at once, then item by item as the Hi-Z pass replays it
+  for (int replay = 0; replay < 2; ++replay) {
+    clear();
+    usize triangles = 0;
+    if (replay == 0) {
+      triangles = render_draw_list(&renderer, &camera, &list, NULL, 0);
+    } else {
+      for (usize i = 0; i < list.count; ++i) triangles += render_draw_item(&renderer, &camera, &list, i, NULL, 0);
+    }
+
+    usize mismatched = 0;
+    for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+      bool a = reference_depth[i] != FLT_MAX, b = depth_buffer[i] != FLT_MAX;
+      if (a != b || (a && (fabsf(reference_depth[i] - depth_buffer[i]) > 0.01f * reference_depth[i] || reference[i] != framebuffer[i]))) mismatched++;
+    }
+
+    if (triangles != reference_triangles) {
+      printf("replay %d: %zu triangles drawn, %zu submitted one by one\n", replay, triangles, reference_triangles);
+      failures++;
+    }
+    if ((float)mismatched > MAX_MISMATCH_SHARE * (float)covered) {
+      printf("replay %d: %zu of %zu pixels differ from the draws placed on the CPU\n", replay, mismatched, covered);
+      failures++;
+    }
+  }
+
+  if (covered < WIDTH * HEIGHT / 10) {
+    printf("the draws cover %zu pixels, the camera does not see them\n", covered);
+    failures++;
+  }
+
+  if (memcmp(&ground, &ground_before, sizeof(model_t)) != 0) {
+    printf("the shared ground model was changed by its draws\n");
+    failures++;
+  }
+  for (int t = 0; t < NUM_TREES; ++t) {
+    const model_t *model = &tree_archetype(trees[t].archetype)->models[tree_instance_scale_step(&trees[t])];
+    if (memcmp(model, &archetype_before[t], sizeof(model_t)) != 0) {
+      printf("archetype %d was changed by its draws\n", trees[t].archetype);
+      failures++;
+    }
+  }
+
+  free_draw_list(&list);
+  free_tree_library();
+  free_config();
+
+  if (failures) return 1;
+  printf("draw list: %zu draws over %zu pixels replay as placed on the CPU\n", (usize)(NUM_GROUND + NUM_TREES), covered);
+  return 0;
+}
@@ -0,0 +1,110 @@
+// post_process_frame must output what apply_fog_to_screen followed by a copy gives, for random
+// colors and depths before, inside and past the fog range and for pixels without depth, and leave
+// the buffers cleared behind it
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <shader-works/renderer.h>
+
+#include "util/color.h"
+#include "util/post_pass.h"
+
+#define WIDTH 157
+#define HEIGHT 64
+#define MAX_DEPTH 60.0f
+
+// the pass blends in 8 bit fixed point, a level of rounding in the weight and one in the blend
+#define CHANNEL_TOLERANCE 2
+
+// out rows are wider than the screen, the pass must keep to the stride
+#define OUT_STRIDE (WIDTH + 3)
+
+static u32 framebuffer[WIDTH * HEIGHT];
+static float depth_buffer[WIDTH * HEIGHT];
+static u32 expected[WIDTH * HEIGHT];
+static u32 colors[WIDTH * HEIGHT];
+static float depths[WIDTH * HEIGHT];
+static u32 out[OUT_STRIDE * HEIGHT];
+
+// xorshift, the pixels are the same on every run
+static inline u32 next_random(u32 *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static inline int channel_difference(u32 a, u32 b, int shift) {
+  return abs((int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff));
+}
+
+static void fill(renderer_t *renderer) {
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    renderer->framebuffer[i] = colors[i];
+    renderer->depth_buffer[i] = depths[i];
+  }
+}
+
+static int check_fog(renderer_t *renderer, float start, float end, u8 r, u8 g, u8 b) {
+  fill(renderer);
+  apply_fog_to_screen(renderer, start, end, r, g, b);
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) expected[i] = renderer->framebuffer[i];
+
+  const u32 background = color_pack(12, 34, 56);
+  fill(renderer);
+  fog_t fog = { .enabled = true, .start = start, .end = end, .color = color_pack(r, g, b) };
+  post_process_frame(renderer, &fog, background, out, OUT_STRIDE);
+
+  int failures = 0;
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    u32 got = out[(i / WIDTH) * OUT_STRIDE + i % WIDTH];
+    if (channel_difference(got, expected[i], COLOR_R_SHIFT) > CHANNEL_TOLERANCE ||
+        channel_difference(got, expected[i], COLOR_G_SHIFT) > CHANNEL_TOLERANCE ||
+        channel_difference(got, expected[i], COLOR_B_SHIFT) > CHANNEL_TOLERANCE) {
+      if (failures++ < 5) {
+        printf("fog [%g, %g]: pixel %zu depth %g color %08x fogged to %08x, apply_fog_to_screen gives %08x\n",
+               start, end, i, depths[i], colors[i], got, expected[i]);
+      }
+    }
+
+    if (renderer->framebuffer[i] != background || renderer->depth_buffer[i] != FLT_MAX) {
+      if (failures++ < 5) printf("pixel %zu not cleared behind the pass\n", i);
+    }
+  }
+
+  return failures;
+}
+
+int main(void) {
+  renderer_t renderer = { 0 };
+  init_renderer(&renderer, WIDTH, HEIGHT, 0, 0, framebuffer, depth_buffer, MAX_DEPTH);
+
+  u32 state = 0x2545f491u;
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    u32 bits = next_random(&state);
+    colors[i] = color_pack((u8)bits, (u8)(bits >> 8), (u8)(bits >> 16));
+    depths[i] = i % 7 == 0 ? FLT_MAX : (float)(next_random(&state) % 65536) / 65536.0f * MAX_DEPTH * 1.1f;
+  }
+
+  int failures = 0;
+  failures += check_fog(&renderer, MAX_DEPTH / 2.0f, MAX_DEPTH - 1.0f, 70, 130, 200);   // the range main uses
+  failures += check_fog(&renderer, 5.0f, 20.0f, 255, 255, 255);
+  failures += check_fog(&renderer, 0.0f, MAX_DEPTH, 0, 0, 0);
+
+  // disabled fog is a plain copy
+  fill(&renderer);
+  fog_t none = { .enabled = false };
+  post_process_frame(&renderer, &none, 0, out, WIDTH);
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    if (out[i] != colors[i] && failures++ < 5) printf("pixel %zu changed with fog disabled\n", i);
+  }
+
+  if (failures) {
+    printf("test_fog: %d failures\n", failures);
+    return 1;
+  }
+
+  printf("fog: post pass within %d levels of apply_fog_to_screen over %d pixels and 3 ranges\n", CHANNEL_TOLERANCE, WIDTH * HEIGHT);
+  return 0;
+}
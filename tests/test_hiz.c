@@ -0,0 +1,131 @@
+// Every box the Hi-Z pyramid rejects must leave the depth it was built from untouched when drawn
+// through render_model, and boxes plainly behind an occluder must be rejected
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <shader-works/renderer.h>
+
+#include "util/hiz.h"
+#include "util/projection.h"
+
+#define WIDTH 160
+#define HEIGHT 120
+#define MAX_DEPTH 60.0f
+
+static u32 framebuffer[WIDTH * HEIGHT];
+static float depth_buffer[WIDTH * HEIGHT];
+static float occluder_depth[WIDTH * HEIGHT];
+
+static u32 flat_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)ctx; (void)args; (void)argc;
+  return 0xffffffffu;
+}
+
+static fragment_shader_t flat_frag = { .func = flat_func, .argv = NULL, .argc = 0, .valid = true };
+
+// Quads are drawn with both windings so back face culling keeps one of each pair
+static usize push_quad(vertex_data_t *out, usize count, float3 a, float3 b, float3 c, float3 d) {
+  const float3 corners[4] = { a, b, c, d };
+  const int order[12] = { 0, 1, 2, 0, 2, 3, 0, 2, 1, 0, 3, 2 };
+  for (int i = 0; i < 12; ++i) out[count++] = (vertex_data_t){ .position = corners[order[i]] };
+  return count;
+}
+
+static void draw(renderer_t *renderer, transform_t *camera, vertex_data_t *vertices, usize count) {
+  float3 face_normals[72] = { 0 };
+  model_t model = { 0 };
+  model.vertex_data = vertices;
+  model.face_normals = face_normals;
+  model.num_vertices = count;
+  model.num_faces = count / 3;
+  model.frag_shader = &flat_frag;
+  render_model(renderer, camera, &model, NULL, 0);
+}
+
+static void draw_box(renderer_t *renderer, transform_t *camera, float3 lo, float3 hi) {
+  vertex_data_t vertices[72];
+  float3 c[8];
+  for (int i = 0; i < 8; ++i) c[i] = make_float3(i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z);
+
+  usize count = 0;
+  count = push_quad(vertices, count, c[0], c[1], c[3], c[2]);
+  count = push_quad(vertices, count, c[4], c[5], c[7], c[6]);
+  count = push_quad(vertices, count, c[0], c[1], c[5], c[4]);
+  count = push_quad(vertices, count, c[2], c[3], c[7], c[6]);
+  count = push_quad(vertices, count, c[0], c[2], c[6], c[4]);
+  count = push_quad(vertices, count, c[1], c[3], c[7], c[5]);
+  draw(renderer, camera, vertices, count);
+}
+
+int main(void) {
+  renderer_t renderer = { 0 };
+  init_renderer(&renderer, WIDTH, HEIGHT, 0, 0, framebuffer, depth_buffer, MAX_DEPTH);
+
+  transform_t camera = { 0 };
+  camera.position = make_float3(5.0f, 8.0f, -3.0f);
+  camera.yaw = 0.4f;
+  camera.pitch = -0.1f;
+  update_camera(&renderer, &camera);
+
+  screen_projection_t projection;
+  init_screen_projection(&projection, &renderer, &camera);
+
+  // a wall over the middle of the screen at depth 12, the edges stay open
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    framebuffer[i] = 0;
+    depth_buffer[i] = FLT_MAX;
+  }
+  vertex_data_t wall[12];
+  push_quad(wall, 0, unproject_from_screen(&projection, WIDTH * 0.2f, HEIGHT * 0.2f, 12.0f), unproject_from_screen(&projection, WIDTH * 0.8f, HEIGHT * 0.2f, 12.0f),
+            unproject_from_screen(&projection, WIDTH * 0.8f, HEIGHT * 0.8f, 12.0f), unproject_from_screen(&projection, WIDTH * 0.2f, HEIGHT * 0.8f, 12.0f));
+  draw(&renderer, &camera, wall, 12);
+  memcpy(occluder_depth, depth_buffer, sizeof(depth_buffer));
+
+  hiz_t hiz;
+  if (init_hiz(&hiz, WIDTH, HEIGHT) != 0) {
+    printf("out of memory\n");
+    return 1;
+  }
+  build_hiz(&hiz, occluder_depth);
+
+  // boxes across the screen, in front of the wall, straddling it and behind it
+  int failures = 0, rejected = 0, tested = 0, expected_rejected = 0;
+  for (int sy = 0; sy < 9; ++sy) {
+    for (int sx = 0; sx < 9; ++sx) {
+      for (int d = 0; d < 5; ++d) {
+        float x = WIDTH * (0.05f + 0.1125f * (float)sx), y = HEIGHT * (0.05f + 0.1125f * (float)sy);
+        float depth = 6.0f + 7.0f * (float)d;
+        float3 center = unproject_from_screen(&projection, x, y, depth);
+        float3 half = make_float3(0.6f, 0.6f, 0.6f);
+        float3 lo = float3_sub(center, half), hi = float3_add(center, half);
+
+        // well inside the wall and well behind it
+        bool hidden = x > WIDTH * 0.3f && x < WIDTH * 0.7f && y > HEIGHT * 0.3f && y < HEIGHT * 0.7f && depth > 16.0f;
+        bool occluded = hiz_test_aabb(&hiz, &projection, lo, hi);
+        tested++;
+        expected_rejected += hidden;
+
+        if (hidden && !occluded) {
+          printf("box at (%.0f, %.0f) depth %.0f is behind the wall but was not rejected\n", x, y, depth);
+          failures++;
+        }
+        if (!occluded) continue;
+        rejected++;
+
+        memcpy(depth_buffer, occluder_depth, sizeof(depth_buffer));
+        draw_box(&renderer, &camera, lo, hi);
+        if (memcmp(depth_buffer, occluder_depth, sizeof(depth_buffer)) != 0) {
+          printf("box at (%.0f, %.0f) depth %.0f was rejected but render_model draws part of it\n", x, y, depth);
+          failures++;
+        }
+      }
+    }
+  }
+
+  free_hiz(&hiz);
+  if (failures) return 1;
+  printf("hi-z: %d of %d boxes rejected (%d plainly hidden), none of them visible\n", rejected, tested, expected_rejected);
+  return 0;
+}
@@ -0,0 +1,161 @@
+// init_screen_projection must put points where render_model draws them, with the depth it writes,
+// and the frustum built from it must keep what is on screen and drop what is behind the camera
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+
+#include <shader-works/renderer.h>
+
+#include "util/frustum.h"
+#include "util/projection.h"
+
+#define WIDTH 200
+#define HEIGHT 150
+#define MAX_DEPTH 40.0f
+
+// centroids of a few dozen pixels are good to about half a pixel
+#define PIXEL_TOLERANCE 1.0f
+#define DEPTH_TOLERANCE 0.01f
+
+static u32 framebuffer[WIDTH * HEIGHT];
+static float depth_buffer[WIDTH * HEIGHT];
+
+static u32 flat_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)ctx; (void)args; (void)argc;
+  return 0xffffffffu;
+}
+
+static fragment_shader_t flat_frag = { .func = flat_func, .argv = NULL, .argc = 0, .valid = true };
+
+typedef struct {
+  usize pixels;
+  float x, y, depth;
+} hit_t;
+
+// A small square at p facing the camera, wound both ways so back face culling keeps one of them
+static hit_t draw_square(renderer_t *renderer, transform_t *camera, const screen_projection_t *projection, float3 p, float half_size) {
+  float3 r = float3_scale(projection->right, half_size), u = float3_scale(projection->up, half_size);
+  float3 corners[4] = { float3_sub(float3_scale(r, -1.0f), u), float3_sub(r, u), float3_add(r, u), float3_add(float3_scale(r, -1.0f), u) };
+  const int order[12] = { 0, 1, 2, 0, 2, 3, 0, 2, 1, 0, 3, 2 };
+
+  vertex_data_t vertices[12];
+  float3 face_normals[4];
+  for (usize i = 0; i < 12; ++i) {
+    float3 normal = float3_scale(projection->view, i < 6 ? -1.0f : 1.0f);
+    vertices[i] = (vertex_data_t){ .position = corners[order[i]], .normal = normal };
+    face_normals[i / 3] = normal;
+  }
+
+  model_t square = { 0 };
+  square.vertex_data = vertices;
+  square.face_normals = face_normals;
+  square.num_vertices = 12;
+  square.num_faces = 4;
+  square.frag_shader = &flat_frag;
+  square.transform.position = p;
+
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    framebuffer[i] = 0;
+    depth_buffer[i] = FLT_MAX;
+  }
+  render_model(renderer, camera, &square, NULL, 0);
+
+  hit_t hit = { 0 };
+  for (uint y = 0; y < HEIGHT; ++y) {
+    for (uint x = 0; x < WIDTH; ++x) {
+      usize i = (usize)y * WIDTH + x;
+      if (depth_buffer[i] == FLT_MAX) continue;
+
+      hit.pixels++;
+      hit.x += (float)x + 0.5f;
+      hit.y += (float)y + 0.5f;
+      hit.depth += depth_buffer[i];
+    }
+  }
+  if (hit.pixels > 0) {
+    hit.x /= (float)hit.pixels;
+    hit.y /= (float)hit.pixels;
+    hit.depth /= (float)hit.pixels;
+  }
+  return hit;
+}
+
+int main(void) {
+  renderer_t renderer = { 0 };
+  init_renderer(&renderer, WIDTH, HEIGHT, 0, 0, framebuffer, depth_buffer, MAX_DEPTH);
+
+  const transform_t cameras[] = {
+    { .position = { 0.0f, 0.0f, 0.0f }, .yaw = 0.0f, .pitch = 0.0f },
+    { .position = { 3.0f, 20.0f, -7.0f }, .yaw = 0.7f, .pitch = 0.2f },
+    { .position = { -40.0f, 5.0f, 12.0f }, .yaw = -2.3f, .pitch = -0.6f },
+  };
+  // screen positions the squares are placed at, as fractions of the screen, and their depths
+  const float targets[][3] = {
+    { 0.5f, 0.5f, 5.0f }, { 0.5f, 0.5f, 20.0f }, { 0.2f, 0.3f, 8.0f }, { 0.8f, 0.25f, 12.0f }, { 0.3f, 0.85f, 15.0f }, { 0.75f, 0.7f, 30.0f }
+  };
+
+  int failures = 0;
+  for (usize c = 0; c < sizeof(cameras) / sizeof(cameras[0]); ++c) {
+    transform_t camera = cameras[c];
+    update_camera(&renderer, &camera);
+
+    screen_projection_t projection;
+    init_screen_projection(&projection, &renderer, &camera);
+
+    for (usize t = 0; t < sizeof(targets) / sizeof(targets[0]); ++t) {
+      float x = targets[t][0] * WIDTH, y = targets[t][1] * HEIGHT, depth = targets[t][2];
+      float3 p = unproject_from_screen(&projection, x, y, depth);
+
+      float3 screen;
+      if (!project_to_screen(&projection, p, &screen) || fabsf(screen.x - x) > 1e-3f * WIDTH || fabsf(screen.y - y) > 1e-3f * HEIGHT) {
+        printf("camera %zu target %zu: unproject_from_screen does not invert project_to_screen\n", c, t);
+        failures++;
+        continue;
+      }
+
+      // about 6 pixels across wherever it is
+      hit_t hit = draw_square(&renderer, &camera, &projection, p, 3.0f * depth / projection.pixels_per_unit);
+      if (hit.pixels == 0) {
+        printf("camera %zu target %zu: render_model drew nothing where (%.1f, %.1f) at depth %.1f was projected\n", c, t, x, y, depth);
+        failures++;
+      } else if (fabsf(hit.x - x) > PIXEL_TOLERANCE || fabsf(hit.y - y) > PIXEL_TOLERANCE) {
+        printf("camera %zu target %zu: projected to (%.2f, %.2f), render_model drew it at (%.2f, %.2f)\n", c, t, x, y, hit.x, hit.y);
+        failures++;
+      } else if (fabsf(hit.depth - depth) > DEPTH_TOLERANCE * depth) {
+        printf("camera %zu target %zu: projected depth %.3f, render_model wrote %.3f\n", c, t, depth, hit.depth);
+        failures++;
+      }
+
+      // the same square behind the camera must not be drawn
+      float3 behind = float3_sub(projection.eye, float3_sub(p, projection.eye));
+      hit_t back = draw_square(&renderer, &camera, &projection, behind, 3.0f * depth / projection.pixels_per_unit);
+      if (back.pixels > 0) {
+        printf("camera %zu target %zu: a square behind the camera was drawn, the view direction is flipped\n", c, t);
+        failures++;
+      }
+    }
+
+    // a box around a point on screen is kept, the same box behind the camera or past max_depth is not
+    frustum_t frustum;
+    init_frustum(&frustum, &projection, &renderer);
+    float3 half = make_float3(2.0f, 2.0f, 2.0f);
+    float3 ahead = float3_add(projection.eye, float3_scale(projection.view, 10.0f));
+    float3 behind = float3_sub(projection.eye, float3_scale(projection.view, 10.0f));
+    float3 beyond = float3_add(projection.eye, float3_scale(projection.view, MAX_DEPTH + 10.0f));
+    float3 aside = unproject_from_screen(&projection, -0.5f * WIDTH, 0.5f * HEIGHT, 10.0f);
+    if (!frustum_test_aabb(&frustum, float3_sub(ahead, half), float3_add(ahead, half))) {
+      printf("camera %zu: the frustum culls a box straight ahead\n", c);
+      failures++;
+    }
+    if (frustum_test_aabb(&frustum, float3_sub(behind, half), float3_add(behind, half)) ||
+        frustum_test_aabb(&frustum, float3_sub(beyond, half), float3_add(beyond, half)) ||
+        frustum_test_aabb(&frustum, float3_sub(aside, half), float3_add(aside, half))) {
+      printf("camera %zu: the frustum keeps a box behind the camera, past max_depth or off screen\n", c);
+      failures++;
+    }
+  }
+
+  if (failures) return 1;
+  printf("projection: %zu cameras, every square drawn by render_model where and as deep as projected\n", sizeof(cameras) / sizeof(cameras[0]));
+  return 0;
+}
@@ -0,0 +1,80 @@
+// Scrolling the snow ground grid must leave exactly the samples a fresh fill would take
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/snow_ground.h"
+
+static int samples_taken = 0;
+
+static float sample_height(void *args, float x, float z) {
+  (void)args;
+  samples_taken++;
+  return sinf(x * 0.37f) * 4.0f + cosf(z * 0.21f) * 3.0f + x * 0.01f;
+}
+
+static int compare_grids(const snow_ground_t *scrolled, const snow_ground_t *fresh, int step) {
+  if (scrolled->origin_x != fresh->origin_x || scrolled->origin_z != fresh->origin_z) {
+    printf("step %d: origin (%g, %g), expected (%g, %g)\n", step, scrolled->origin_x, scrolled->origin_z, fresh->origin_x, fresh->origin_z);
+    return 1;
+  }
+
+  int count = scrolled->size * scrolled->size;
+  for (int i = 0; i < count; i++) {
+    if (scrolled->heights[i] != fresh->heights[i]) {
+      printf("step %d: sample (%d, %d) is %g, expected %g\n", step, i % scrolled->size, i / scrolled->size, scrolled->heights[i], fresh->heights[i]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(void) {
+  snow_ground_t scrolled, fresh;
+  if (init_snow_ground(&scrolled, 50.0f) || init_snow_ground(&fresh, 50.0f)) {
+    printf("out of memory\n");
+    return 1;
+  }
+
+  // a walk mixing steps within a cell, across a few cells in both directions and jumps past the grid
+  float x = 3.0f, z = -7.0f;
+  int failures = 0, scrolled_samples = 0, full_samples = 0;
+  srand(1234);
+  for (int step = 0; step < 2000 && !failures; step++) {
+    int kind = rand() % 10;
+    float range = kind == 0 ? 400.0f : (kind < 4 ? 12.0f : 2.5f);
+    x += ((float)rand() / RAND_MAX - 0.5f) * range;
+    z += ((float)rand() / RAND_MAX - 0.5f) * range;
+
+    samples_taken = 0;
+    update_snow_ground(&scrolled, x, z, sample_height, NULL);
+    scrolled_samples += samples_taken;
+
+    fresh.valid = false;
+    samples_taken = 0;
+    update_snow_ground(&fresh, x, z, sample_height, NULL);
+    full_samples += samples_taken;
+
+    failures += compare_grids(&scrolled, &fresh, step);
+
+    // the grid points themselves interpolate to the sampled height
+    float gx = fresh.origin_x + SNOW_GROUND_STEP * 7, gz = fresh.origin_z + SNOW_GROUND_STEP * 11;
+    float expected = fresh.heights[11 * fresh.size + 7];
+    if (!failures && fabsf(snow_ground_height(&scrolled, gx, gz) - expected) > 1e-4f) {
+      printf("step %d: height at a sample is %g, expected %g\n", step, snow_ground_height(&scrolled, gx, gz), expected);
+      failures++;
+    }
+  }
+
+  if (!failures && scrolled_samples * 2 > full_samples) {
+    printf("scrolling took %d samples against %d for full fills\n", scrolled_samples, full_samples);
+    failures++;
+  }
+
+  free_snow_ground(&scrolled);
+  free_snow_ground(&fresh);
+
+  if (failures) return 1;
+  printf("snow ground: scrolled grid matches a fresh fill, %d samples against %d\n", scrolled_samples, full_samples);
+  return 0;
+}
@@ -0,0 +1,140 @@
+// A tree mesh drawn with its turn in model_t.transform must cover the pixels, at the depths, of the
+// same mesh turned on the CPU by tree_transform_point, which bounds, shadows and impostors rely on
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <shader-works/renderer.h>
+
+#include "util/chunk_map.h"
+
+#define WIDTH 160
+#define HEIGHT 120
+#define MAX_DEPTH 60.0f
+
+// pixels along triangle edges may round either way, anything past this share is a different turn
+#define MAX_MISMATCH_SHARE 0.02f
+
+static u32 framebuffer[WIDTH * HEIGHT];
+static float depth_buffer[WIDTH * HEIGHT];
+static float reference_depth[WIDTH * HEIGHT];
+
+static u32 flat_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)ctx; (void)args; (void)argc;
+  return 0xffffffffu;
+}
+
+static fragment_shader_t flat_frag = { .func = flat_func, .argv = NULL, .argc = 0, .valid = true };
+
+// An L of two upright boxes off the trunk axis, so any wrong turn or mirror moves it on screen
+static usize build_mesh(vertex_data_t *out) {
+  static const float boxes[2][6] = {
+    { 0.5f, 0.0f, -0.5f, 3.0f, 4.0f, 0.5f },    // min x, y, z, max x, y, z
+    { -0.5f, 0.0f, 0.5f, 0.5f, 2.5f, 2.5f },
+  };
+  static const int faces[6][4] = {
+    { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 }
+  };
+
+  usize count = 0;
+  for (int b = 0; b < 2; ++b) {
+    float3 corners[8];
+    for (int c = 0; c < 8; ++c) {
+      corners[c] = make_float3(boxes[b][c & 1 ? 3 : 0], boxes[b][c & 2 ? 4 : 1], boxes[b][c & 4 ? 5 : 2]);
+    }
+
+    for (int f = 0; f < 6; ++f) {
+      const int quad[6] = { faces[f][0], faces[f][1], faces[f][2], faces[f][0], faces[f][2], faces[f][3] };
+      for (int v = 0; v < 6; ++v) out[count++] = (vertex_data_t){ .position = corners[quad[v]] };
+    }
+  }
+  return count;
+}
+
+static void clear(void) {
+  for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+    framebuffer[i] = 0;
+    depth_buffer[i] = FLT_MAX;
+  }
+}
+
+int main(void) {
+  vertex_data_t mesh[72], turned[72];
+  float3 face_normals[24] = { 0 };
+  usize num_vertices = build_mesh(mesh);
+
+  renderer_t renderer = { 0 };
+  init_renderer(&renderer, WIDTH, HEIGHT, 0, 0, framebuffer, depth_buffer, MAX_DEPTH);
+
+  transform_t camera = { 0 };
+  camera.position = make_float3(0.0f, 2.0f, 0.0f);
+
+  int failures = 0;
+  for (int yaw = 0; yaw < 256 && !failures; yaw += 23) {
+    for (int view = 0; view < 4 && !failures; ++view) {
+      // the tree in front of cameras looking along both axes both ways
+      camera.yaw = (float)view * PI / 2.0f;
+      camera.pitch = -0.2f;
+      update_camera(&renderer, &camera);
+
+      float3 right, up, forward;
+      transform_get_basis_vectors(&camera, &right, &up, &forward);
+      tree_instance_t instance = { .archetype = 0, .yaw = (u8)yaw, .scale = 255 };
+      instance.position = float3_add(camera.position, float3_scale(forward, -12.0f));
+      instance.position.y = 0.0f;
+
+      // turned on the CPU, drawn with an identity turn
+      tree_transform_t transform = tree_instance_transform(&instance);
+      transform.position = make_float3(0, 0, 0);
+      for (usize v = 0; v < num_vertices; ++v) {
+        turned[v] = mesh[v];
+        turned[v].position = tree_transform_point(&transform, mesh[v].position);
+      }
+
+      model_t model = { 0 };
+      model.vertex_data = turned;
+      model.face_normals = face_normals;
+      model.num_vertices = num_vertices;
+      model.num_faces = num_vertices / 3;
+      model.frag_shader = &flat_frag;
+      model.transform.position = instance.position;
+
+      clear();
+      render_model(&renderer, &camera, &model, NULL, 0);
+      usize covered = 0;
+      for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+        reference_depth[i] = depth_buffer[i];
+        covered += depth_buffer[i] != FLT_MAX;
+      }
+
+      // the mesh scaled the same, turned by the transform the way draw_list.c draws trees
+      for (usize v = 0; v < num_vertices; ++v) {
+        turned[v] = mesh[v];
+        turned[v].position = float3_scale(mesh[v].position, transform.scale);
+      }
+      model.transform.yaw = tree_instance_yaw(&instance);
+
+      clear();
+      render_model(&renderer, &camera, &model, NULL, 0);
+
+      usize mismatched = 0;
+      for (usize i = 0; i < WIDTH * HEIGHT; ++i) {
+        bool a = reference_depth[i] != FLT_MAX, b = depth_buffer[i] != FLT_MAX;
+        if (a != b || (a && fabsf(reference_depth[i] - depth_buffer[i]) > 0.01f * reference_depth[i])) mismatched++;
+      }
+
+      if (covered == 0) {
+        printf("yaw %d view %d: the tree is not on screen\n", yaw, view);
+        failures++;
+      } else if ((float)mismatched > MAX_MISMATCH_SHARE * (float)covered) {
+        printf("yaw %d view %d: %zu of %zu pixels differ between the transform's turn and tree_transform_point\n", yaw, view, mismatched, covered);
+        failures++;
+      }
+    }
+  }
+
+  if (failures) return 1;
+  printf("tree transform: render_model turns meshes the way tree_transform_point does\n");
+  return 0;
+}